@@ -0,0 +1,295 @@
+/*
+* Copyright (c) 2024 Stephen O Driscoll
+*
+* Distributed under the MIT License (See accompanying file LICENSE)
+* Official repository: https://github.com/Stephen-ODriscoll/PlutoUtils
+*/
+
+// Measures Logger producer latency, sustained throughput, bytes written per second and
+// allocations per log for writef, write and stream, with and without file rotation.
+// Results are printed as JSON. Usage: pluto_logger_benchmarks [--threads N] [--logs N]
+
+#define PLUTO_LOGGER_NO_SINGLETON 1
+
+#include "pluto/logger.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "allocation_counter.hpp"
+
+#define LOG_DIR "benchmark_logs"
+#define LOG_FILE LOG_DIR "/benchmark.log"
+#define ROTATION_SIZE (1024 * 1024)
+#define ALLOCATION_LOGS 20000
+#define ALLOCATION_BURST_SIZE 500  // Less than the default buffer recycle size
+
+// Discards logs so only the logger itself is measured
+class NullSink : public pluto::Logger::Sink
+{
+public:
+    bool write(const pluto::Logger::LogBatch&) override
+    {
+        return true;
+    }
+};
+
+enum class Method
+{
+    Write,
+    Writef,
+    Stream
+};
+
+const char* methodName(const Method method)
+{
+    switch (method)
+    {
+        case Method::Write:     return "write";
+        case Method::Writef:    return "writef";
+        case Method::Stream:    return "stream";
+        default:                return "unknown";
+    }
+}
+
+const std::string g_logFileName{ LOG_FILE };
+const std::string g_message{ "Benchmark log message with enough text to need the heap" };
+
+void log(pluto::Logger& logger, const Method method, const std::size_t i)
+{
+    switch (method)
+    {
+        case Method::Write:
+            logger.write(g_logFileName, pluto::Logger::Level::Info, __FILE__, __LINE__, __func__, g_message);
+            break;
+
+        case Method::Writef:
+            logger.writef(g_logFileName, pluto::Logger::Level::Info, __FILE__, __LINE__, __func__,
+                "Benchmark log message %zu with enough text to need the heap", i);
+            break;
+
+        case Method::Stream:
+            logger.stream(g_logFileName, pluto::Logger::Level::Info, __FILE__, __LINE__, __func__)
+                << "Benchmark log message " << i << " with enough text to need the heap";
+            break;
+    }
+}
+
+std::size_t directorySize(const char* const path)
+{
+    std::size_t size{ 0 };
+
+    for (const auto& entry : pluto::FileSystem::directory_iterator{ path })
+    {
+        size += static_cast<std::size_t>(pluto::FileSystem::file_size(entry.path()));
+    }
+
+    return size;
+}
+
+struct ThroughputResult
+{
+    double                  logsPerSecond;
+    double                  bytesPerSecond;
+    std::vector<long long>  latencies;  // Nanoseconds per call, sorted
+};
+
+// Each thread logs numLogs logs. Timing stops once the logger is destroyed, so every log is on disk.
+ThroughputResult benchmarkThroughput(
+    const Method        method,
+    const bool          rotation,
+    const std::size_t   numThreads,
+    const std::size_t   numLogs)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    pluto::FileSystem::remove_all(LOG_DIR);
+
+    std::vector<std::vector<long long>> threadLatencies(numThreads, std::vector<long long>(numLogs));
+    std::atomic_size_t numReady{ 0 };
+    std::atomic_bool start{ false };
+    Clock::time_point startTime{};
+
+    {
+        // Keep every rotated file so the bytes written can be counted
+        pluto::Logger logger{};
+        logger
+            .fileRotationSize(rotation ? ROTATION_SIZE : 0)
+            .fileRotationLimit(rotation ? 100000 : 1);
+
+        std::vector<std::thread> threads{};
+        for (std::size_t t{ 0 }; t < numThreads; ++t)
+        {
+            threads.emplace_back([&, t]()
+                {
+                    auto& latencies{ threadLatencies[t] };
+
+                    ++numReady;
+                    while (!start.load());
+
+                    for (std::size_t i{ 0 }; i < numLogs; ++i)
+                    {
+                        const auto logStart{ Clock::now() };
+                        log(logger, method, i);
+                        latencies[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            Clock::now() - logStart).count();
+                    }
+                });
+        }
+
+        while (numReady.load() != numThreads);
+        startTime = Clock::now();
+        start.store(true);
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    const auto seconds{ std::chrono::duration<double>(Clock::now() - startTime).count() };
+
+    ThroughputResult result{};
+    result.logsPerSecond = static_cast<double>(numThreads * numLogs) / seconds;
+    result.bytesPerSecond = static_cast<double>(directorySize(LOG_DIR)) / seconds;
+
+    for (const auto& latencies : threadLatencies)
+    {
+        result.latencies.insert(result.latencies.end(), latencies.begin(), latencies.end());
+    }
+
+    std::sort(result.latencies.begin(), result.latencies.end());
+    pluto::FileSystem::remove_all(LOG_DIR);
+
+    return result;
+}
+
+long long percentile(const std::vector<long long>& sorted, const double p)
+{
+    const auto index{ static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1)) };
+    return sorted[index];
+}
+
+// Logs in bursts the writer can keep up with, so recycled logs are measured in steady state.
+// Without recycling every log allocates, for comparison. Returns allocations per log on the
+// producer thread and in total.
+std::pair<double, double> benchmarkAllocations(const Method method, const bool recycling)
+{
+    pluto::Logger logger{};
+    logger.sink(g_logFileName, std::make_shared<NullSink>());
+
+    if (!recycling)
+    {
+        logger.bufferRecycleSize(0);
+    }
+
+    const auto logBursts{ [&]()
+        {
+            for (std::size_t i{ 0 }; i < ALLOCATION_LOGS; ++i)
+            {
+                log(logger, method, i);
+
+                if ((i % ALLOCATION_BURST_SIZE) == (ALLOCATION_BURST_SIZE - 1))
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                }
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        } };
+
+    // The first round warms up the logger
+    logBursts();
+
+    g_numAllocations.store(0);
+    t_numAllocations = 0;
+    g_countAllocations.store(true);
+
+    logBursts();
+
+    g_countAllocations.store(false);
+
+    return {
+        (static_cast<double>(t_numAllocations) / ALLOCATION_LOGS),
+        (static_cast<double>(g_numAllocations.load()) / ALLOCATION_LOGS) };
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t maxThreads{ std::max(std::thread::hardware_concurrency(), 1u) };
+    std::size_t numLogs{ 100000 };
+
+    for (int i{ 1 }; (i + 1) < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--threads") == 0)
+        {
+            maxThreads = std::max(std::stoul(argv[i + 1]), 1ul);
+        }
+        else if (std::strcmp(argv[i], "--logs") == 0)
+        {
+            numLogs = std::max(std::stoul(argv[i + 1]), 1ul);
+        }
+    }
+
+    const Method methods[]{ Method::Writef, Method::Write, Method::Stream };
+
+    std::cout << std::fixed << std::setprecision(2)
+        << "{\n"
+        << "  \"logsPerThread\": " << numLogs << ",\n"
+        << "  \"throughput\": [";
+
+    auto first{ true };
+    for (const auto method : methods)
+    {
+        for (const auto rotation : { false, true })
+        {
+            // Doubles up to the number of threads the machine runs at once, ending there even if it isn't a power of 2
+            for (std::size_t numThreads{ 1 }; numThreads <= maxThreads;
+                numThreads = (numThreads == maxThreads) ? (maxThreads + 1) : std::min((numThreads * 2), maxThreads))
+            {
+                const auto result{ benchmarkThroughput(method, rotation, numThreads, numLogs) };
+                const auto& latencies{ result.latencies };
+
+                std::cout << (first ? "\n" : ",\n")
+                    << "    { \"method\": \"" << methodName(method) << "\""
+                    << ", \"rotation\": " << (rotation ? "true" : "false")
+                    << ", \"threads\": " << numThreads
+                    << ", \"logsPerSecond\": " << result.logsPerSecond
+                    << ", \"bytesPerSecond\": " << result.bytesPerSecond
+                    << ", \"latencyNs\": { \"p50\": " << percentile(latencies, 0.5)
+                    << ", \"p90\": " << percentile(latencies, 0.9)
+                    << ", \"p99\": " << percentile(latencies, 0.99)
+                    << ", \"p999\": " << percentile(latencies, 0.999)
+                    << ", \"max\": " << latencies.back() << " } }" << std::flush;
+
+                first = false;
+            }
+        }
+    }
+
+    std::cout << "\n  ],\n"
+        << "  \"allocations\": [";
+
+    first = true;
+    for (const auto method : methods)
+    {
+        for (const auto recycling : { false, true })
+        {
+            const auto result{ benchmarkAllocations(method, recycling) };
+
+            std::cout << (first ? "\n" : ",\n")
+                << "    { \"method\": \"" << methodName(method) << "\""
+                << ", \"recycling\": " << (recycling ? "true" : "false")
+                << ", \"producerPerLog\": " << result.first
+                << ", \"totalPerLog\": " << result.second << " }" << std::flush;
+
+            first = false;
+        }
+    }
+
+    std::cout << "\n  ]\n"
+        << "}\n";
+
+    return 0;
+}
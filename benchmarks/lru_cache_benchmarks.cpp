@@ -0,0 +1,622 @@
+/*
+* Copyright (c) 2024 Stephen O Driscoll
+*
+* Distributed under the MIT License (See accompanying file LICENSE)
+* Official repository: https://github.com/Stephen-ODriscoll/PlutoUtils
+*/
+
+// Measures LRUCache inserts, hits and a mixed hit/miss workload from 1K to 10M entries, with each
+// eviction policy, with entries that expire and against the previous std::map + std::list implementation. Also counts allocations per operation
+// and the memory each entry takes with integer and string keys, the hit ratio of each policy on
+// skewed traces with and without scans, and compares the throughput and hit ratio of SafeLRUCache
+// against ShardedLRUCache with several threads reading and writing at once.
+// Results are printed as JSON. Usage: pluto_lru_cache_benchmarks [--max-entries N] [--ops N] [--threads N]
+
+#include "pluto/lru_cache.hpp"
+#include "pluto/safe_lru_cache.hpp"
+#include "pluto/sharded_lru_cache.hpp"
+
+#include <map>
+#include <list>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include <string>
+#include <cstring>
+#include <iomanip>
+#include <algorithm>
+#include <iostream>
+
+#include "allocation_counter.hpp"
+
+// The previous LRUCache, kept as the baseline
+template<class KeyT, class ValueT>
+class MapLRUCache
+{
+public:
+    typedef KeyT KeyType;
+    typedef ValueT ValueType;
+    typedef std::list<KeyType> ListType;
+    typedef std::map<KeyType, std::pair<ValueType, typename ListType::iterator>> MapType;
+
+private:
+    std::size_t m_capacity;
+    ListType    m_list{};
+    MapType     m_map{};
+
+public:
+    MapLRUCache(const std::size_t capacity) :
+        m_capacity{ capacity } {}
+
+    std::size_t size() const { return m_map.size(); }
+
+    void insert(const KeyType& key, const ValueType& value)
+    {
+        auto itMap{ m_map.find(key) };
+        if (itMap == m_map.end())
+        {
+            if (m_capacity != 0)
+            {
+                if (m_capacity <= size())
+                {
+                    evictLRU();
+                }
+
+                m_list.push_front(key);
+                m_map.emplace(key, std::make_pair(value, m_list.begin()));
+            }
+        }
+        else
+        {
+            itMap->second.first = value;
+            moveToFront(itMap);
+        }
+    }
+
+    bool get(const KeyType& key, ValueType& value)
+    {
+        auto itMap{ m_map.find(key) };
+        if (itMap == m_map.end())
+        {
+            return false;
+        }
+
+        value = itMap->second.first;
+        moveToFront(itMap);
+        return true;
+    }
+
+private:
+    void moveToFront(typename MapType::iterator itMap)
+    {
+        auto itList{ itMap->second.second };
+        if (itList != m_list.begin())
+        {
+            m_list.erase(itList);
+            m_list.push_front(itMap->first);
+
+            itMap->second.second = m_list.begin();
+        }
+    }
+
+    void evictLRU()
+    {
+        auto itList{ --m_list.end() };
+        m_map.erase(*itList);
+        m_list.erase(itList);
+    }
+};
+
+template<class KeyT, class ValueT>
+using ClockLRUCache = pluto::LRUCache<KeyT, ValueT, std::hash<KeyT>, std::equal_to<KeyT>, pluto::ClockPolicy>;
+
+template<class KeyT, class ValueT>
+using ClockProLRUCache = pluto::LRUCache<KeyT, ValueT, std::hash<KeyT>, std::equal_to<KeyT>, pluto::ClockProPolicy>;
+
+template<class KeyT, class ValueT>
+using TinyLFULRUCache = pluto::LRUCache<KeyT, ValueT, std::hash<KeyT>, std::equal_to<KeyT>, pluto::TinyLFUPolicy>;
+
+template<class KeyT, class ValueT>
+using ARCLRUCache = pluto::LRUCache<KeyT, ValueT, std::hash<KeyT>, std::equal_to<KeyT>, pluto::ARCPolicy>;
+
+template<class KeyT, class ValueT>
+using TwoQueueLRUCache = pluto::LRUCache<KeyT, ValueT, std::hash<KeyT>, std::equal_to<KeyT>, pluto::TwoQueuePolicy>;
+
+// Allocates every node up front
+template<class KeyT, class ValueT>
+class PreallocatedLRUCache : public pluto::LRUCache<KeyT, ValueT>
+{
+public:
+    PreallocatedLRUCache(const std::size_t capacity) :
+        pluto::LRUCache<KeyT, ValueT>{ capacity, true } {}
+};
+
+// Every entry has a time to live, long enough that none expire, so each operation reads the clock
+// and advances the timing wheel
+template<class KeyT, class ValueT>
+class ExpiringLRUCache : public pluto::LRUCache<KeyT, ValueT, std::hash<KeyT>, std::equal_to<KeyT>, pluto::LRUPolicy, pluto::TimerWheelExpiry<>>
+{
+public:
+    ExpiringLRUCache(const std::size_t capacity) :
+        pluto::LRUCache<KeyT, ValueT, std::hash<KeyT>, std::equal_to<KeyT>, pluto::LRUPolicy, pluto::TimerWheelExpiry<>>{ capacity }
+    {
+        this->timeToLive(std::chrono::hours(1));
+    }
+};
+
+struct Result
+{
+    double insertsPerSecond;
+    double hitsPerSecond;
+    double mixedPerSecond;
+    double hitRatio;                // Of the mixed workload
+    double allocationsPerInsert;    // Filling the cache
+    double allocationsPerHit;
+    double allocationsPerMixed;
+};
+
+// Keys are shuffled so neither implementation benefits from inserting in order
+template<class CacheT>
+Result benchmark(const std::size_t numEntries, const std::size_t numOps)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::mt19937_64 random{ numEntries };
+    std::vector<std::size_t> keys(numEntries);
+
+    for (std::size_t i{ 0 }; i < numEntries; ++i)
+    {
+        keys[i] = i;
+    }
+
+    std::shuffle(keys.begin(), keys.end(), random);
+
+    // Hits pick from the cached keys, the mixed workload from twice as many so about half miss
+    std::vector<std::size_t> hitKeys(numOps);
+    std::vector<std::size_t> mixedKeys(numOps);
+
+    for (std::size_t i{ 0 }; i < numOps; ++i)
+    {
+        hitKeys[i] = keys[random() % numEntries];
+        mixedKeys[i] = random() % (numEntries * 2);
+    }
+
+    Result result{};
+    std::size_t value{ 0 };
+    std::size_t checksum{ 0 };
+    CacheT cache{ numEntries };
+
+    g_numAllocations = 0;
+    g_countAllocations = true;
+    auto start{ Clock::now() };
+
+    for (const auto key : keys)
+    {
+        cache.insert(key, key);
+    }
+
+    auto seconds{ std::chrono::duration<double>(Clock::now() - start).count() };
+    g_countAllocations = false;
+    result.insertsPerSecond = static_cast<double>(numEntries) / seconds;
+    result.allocationsPerInsert = static_cast<double>(g_numAllocations) / static_cast<double>(numEntries);
+
+    g_numAllocations = 0;
+    g_countAllocations = true;
+    start = Clock::now();
+
+    for (const auto key : hitKeys)
+    {
+        checksum += cache.get(key, value) ? value : 0;
+    }
+
+    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    g_countAllocations = false;
+    result.hitsPerSecond = static_cast<double>(numOps) / seconds;
+    result.allocationsPerHit = static_cast<double>(g_numAllocations) / static_cast<double>(numOps);
+
+    // Misses insert the key, evicting the least recently used entry
+    std::size_t numHits{ 0 };
+    g_numAllocations = 0;
+    g_countAllocations = true;
+    start = Clock::now();
+
+    for (const auto key : mixedKeys)
+    {
+        if (cache.get(key, value))
+        {
+            ++numHits;
+            checksum += value;
+        }
+        else
+        {
+            cache.insert(key, key);
+        }
+    }
+
+    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    g_countAllocations = false;
+    result.mixedPerSecond = static_cast<double>(numOps) / seconds;
+    result.hitRatio = static_cast<double>(numHits) / static_cast<double>(numOps);
+    result.allocationsPerMixed = static_cast<double>(g_numAllocations) / static_cast<double>(numOps);
+
+    // Keeps the lookups from being optimized away
+    if (checksum == 1)
+    {
+        std::cerr << checksum;
+    }
+
+    return result;
+}
+
+struct MemoryResult
+{
+    double bytesPerEntry;
+    double allocationsPerEntry;
+};
+
+// Keys are made before counting, so only the cache's own copies are measured
+template<class CacheT>
+MemoryResult benchmarkMemory(const std::vector<typename CacheT::KeyType>& keys)
+{
+    MemoryResult result{};
+
+    const auto numBytesInUse{ g_numBytesInUse.load() };
+    CacheT cache{ keys.size() };
+
+    g_numAllocations = 0;
+    g_countAllocations = true;
+
+    for (const auto& key : keys)
+    {
+        cache.insert(key, 0);
+    }
+
+    g_countAllocations = false;
+
+    result.bytesPerEntry = static_cast<double>(g_numBytesInUse - numBytesInUse) / static_cast<double>(keys.size());
+    result.allocationsPerEntry = static_cast<double>(g_numAllocations) / static_cast<double>(keys.size());
+
+    return result;
+}
+
+struct ConcurrentResult
+{
+    double opsPerSecond;
+    double hitRatio;    // Shows what the hits buffered reads drop cost
+};
+
+// Each thread looks up its own part of one trace. Like most shared caches it's read heavy,
+// and popularity is skewed so the hit ratio depends on the cache keeping hits in order.
+template<class CacheT>
+ConcurrentResult benchmarkConcurrent(
+    CacheT&                         cache,
+    const std::size_t               numThreads,
+    const std::size_t               numEntries,
+    const std::vector<std::size_t>& trace)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const auto numOps{ trace.size() / numThreads };
+
+    for (std::size_t i{ 0 }; i < numEntries; ++i)
+    {
+        cache.insert(i, i);
+    }
+
+    std::vector<std::size_t> threadHits(numThreads);
+    std::vector<std::thread> threads{};
+    const auto start{ Clock::now() };
+
+    for (std::size_t t{ 0 }; t < numThreads; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            std::size_t value{ 0 };
+            std::size_t numHits{ 0 };
+
+            for (std::size_t i{ t * numOps }; i < ((t + 1) * numOps); ++i)
+            {
+                if (cache.get(trace[i], value))
+                {
+                    ++numHits;
+                }
+                else
+                {
+                    cache.insert(trace[i], trace[i]);
+                }
+            }
+
+            threadHits[t] = numHits;
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    const auto seconds{ std::chrono::duration<double>(Clock::now() - start).count() };
+
+    std::size_t numHits{ 0 };
+    for (const auto hits : threadHits)
+    {
+        numHits += hits;
+    }
+
+    ConcurrentResult result{};
+    result.opsPerSecond = static_cast<double>(numThreads * numOps) / seconds;
+    result.hitRatio = static_cast<double>(numHits) / static_cast<double>(numThreads * numOps);
+    return result;
+}
+
+// Requests keys with Zipf distributed popularity, the most popular key is requested most
+std::vector<std::size_t> makeZipfTrace(const std::size_t numKeys, const std::size_t numRequests, const double exponent)
+{
+    std::vector<double> cumulative(numKeys);
+    double total{ 0 };
+
+    for (std::size_t i{ 0 }; i < numKeys; ++i)
+    {
+        total += 1.0 / std::pow(static_cast<double>(i + 1), exponent);
+        cumulative[i] = total;
+    }
+
+    std::mt19937_64 random{ numKeys };
+    std::uniform_real_distribution<double> distribution{ 0, total };
+    std::vector<std::size_t> trace(numRequests);
+
+    for (auto& key : trace)
+    {
+        const auto it{ std::lower_bound(cumulative.begin(), cumulative.end(), distribution(random)) };
+        key = std::min(static_cast<std::size_t>(it - cumulative.begin()), numKeys - 1);
+    }
+
+    return trace;
+}
+
+// Every interval requests, a scan of keys never requested before or again
+std::vector<std::size_t> addScans(const std::vector<std::size_t>& trace, const std::size_t interval, const std::size_t scanSize)
+{
+    std::vector<std::size_t> scanned{};
+    std::size_t nextScanKey{ static_cast<std::size_t>(1) << 40 };
+
+    for (std::size_t i{ 0 }; i < trace.size(); ++i)
+    {
+        if (i != 0 && (i % interval) == 0)
+        {
+            for (std::size_t j{ 0 }; j < scanSize; ++j)
+            {
+                scanned.push_back(nextScanKey++);
+            }
+        }
+
+        scanned.push_back(trace[i]);
+    }
+
+    return scanned;
+}
+
+// Misses insert the key, as a cache in front of a slower store would
+template<class CacheT>
+double hitRatio(const std::vector<std::size_t>& trace, const std::size_t capacity)
+{
+    CacheT cache{ capacity };
+    std::size_t value{ 0 };
+    std::size_t numHits{ 0 };
+
+    for (const auto key : trace)
+    {
+        if (cache.get(key, value))
+        {
+            ++numHits;
+        }
+        else
+        {
+            cache.insert(key, key);
+        }
+    }
+
+    return static_cast<double>(numHits) / static_cast<double>(trace.size());
+}
+
+void printHitRatio(const char* const trace, const char* const name, const double ratio, const bool first)
+{
+    std::cout << (first ? "\n" : ",\n")
+        << "    { \"trace\": \"" << trace << "\""
+        << ", \"cache\": \"" << name << "\""
+        << ", \"hitRatio\": " << ratio << " }" << std::flush;
+}
+
+void printHitRatios(const char* const trace, const std::vector<std::size_t>& keys, const std::size_t capacity, const bool first)
+{
+    printHitRatio(trace, "LRUCache", hitRatio<pluto::LRUCache<std::size_t, std::size_t>>(keys, capacity), first);
+    printHitRatio(trace, "ClockLRUCache", hitRatio<ClockLRUCache<std::size_t, std::size_t>>(keys, capacity), false);
+    printHitRatio(trace, "ClockProLRUCache", hitRatio<ClockProLRUCache<std::size_t, std::size_t>>(keys, capacity), false);
+    printHitRatio(trace, "TinyLFULRUCache", hitRatio<TinyLFULRUCache<std::size_t, std::size_t>>(keys, capacity), false);
+    printHitRatio(trace, "ARCLRUCache", hitRatio<ARCLRUCache<std::size_t, std::size_t>>(keys, capacity), false);
+    printHitRatio(trace, "TwoQueueLRUCache", hitRatio<TwoQueueLRUCache<std::size_t, std::size_t>>(keys, capacity), false);
+}
+
+void printConcurrentResult(const char* const name, const std::size_t numThreads, const ConcurrentResult& result, const bool first)
+{
+    std::cout << (first ? "\n" : ",\n")
+        << "    { \"cache\": \"" << name << "\""
+        << ", \"threads\": " << numThreads
+        << ", \"opsPerSecond\": " << result.opsPerSecond
+        << ", \"hitRatio\": " << std::setprecision(4) << result.hitRatio << std::setprecision(2) << " }" << std::flush;
+}
+
+void printMemoryResult(const char* const name, const char* const keyType, const MemoryResult& result, const bool first)
+{
+    std::cout << (first ? "\n" : ",\n")
+        << "    { \"cache\": \"" << name << "\""
+        << ", \"key\": \"" << keyType << "\""
+        << ", \"bytesPerEntry\": " << result.bytesPerEntry
+        << ", \"allocationsPerEntry\": " << result.allocationsPerEntry << " }" << std::flush;
+}
+
+void printResult(const char* const name, const std::size_t numEntries, const Result& result, const bool first)
+{
+    std::cout << (first ? "\n" : ",\n")
+        << "    { \"cache\": \"" << name << "\""
+        << ", \"entries\": " << numEntries
+        << ", \"insertsPerSecond\": " << result.insertsPerSecond
+        << ", \"hitsPerSecond\": " << result.hitsPerSecond
+        << ", \"mixedPerSecond\": " << result.mixedPerSecond
+        << ", \"mixedHitRatio\": " << result.hitRatio
+        << ", \"allocations\": { \"perInsert\": " << result.allocationsPerInsert
+        << ", \"perHit\": " << result.allocationsPerHit
+        << ", \"perMixed\": " << result.allocationsPerMixed << " } }" << std::flush;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t maxEntries{ 10000000 };
+    std::size_t numOps{ 1000000 };
+    std::size_t numThreads{ std::max<std::size_t>(std::thread::hardware_concurrency(), 1) };
+
+    for (int i{ 1 }; (i + 1) < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--max-entries") == 0)
+        {
+            maxEntries = std::max(std::stoul(argv[i + 1]), 1ul);
+        }
+        else if (std::strcmp(argv[i], "--ops") == 0)
+        {
+            numOps = std::max(std::stoul(argv[i + 1]), 1ul);
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0)
+        {
+            numThreads = std::max(std::stoul(argv[i + 1]), 1ul);
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(2)
+        << "{\n"
+        << "  \"ops\": " << numOps << ",\n"
+        << "  \"results\": [";
+
+    auto first{ true };
+    for (std::size_t numEntries{ 1000 }; numEntries <= maxEntries; numEntries *= 10)
+    {
+        printResult("LRUCache", numEntries,
+            benchmark<pluto::LRUCache<std::size_t, std::size_t>>(numEntries, numOps), first);
+
+        printResult("PreallocatedLRUCache", numEntries,
+            benchmark<PreallocatedLRUCache<std::size_t, std::size_t>>(numEntries, numOps), false);
+
+        printResult("ClockLRUCache", numEntries,
+            benchmark<ClockLRUCache<std::size_t, std::size_t>>(numEntries, numOps), false);
+
+        printResult("ClockProLRUCache", numEntries,
+            benchmark<ClockProLRUCache<std::size_t, std::size_t>>(numEntries, numOps), false);
+
+        printResult("TinyLFULRUCache", numEntries,
+            benchmark<TinyLFULRUCache<std::size_t, std::size_t>>(numEntries, numOps), false);
+
+        printResult("ARCLRUCache", numEntries,
+            benchmark<ARCLRUCache<std::size_t, std::size_t>>(numEntries, numOps), false);
+
+        printResult("TwoQueueLRUCache", numEntries,
+            benchmark<TwoQueueLRUCache<std::size_t, std::size_t>>(numEntries, numOps), false);
+
+        printResult("ExpiringLRUCache", numEntries,
+            benchmark<ExpiringLRUCache<std::size_t, std::size_t>>(numEntries, numOps), false);
+
+        printResult("MapLRUCache", numEntries,
+            benchmark<MapLRUCache<std::size_t, std::size_t>>(numEntries, numOps), false);
+
+        first = false;
+    }
+
+    // Strings long enough to need the heap, like most real keys
+    const std::size_t numMemoryEntries{ 100000 };
+    std::vector<std::size_t> integerKeys(numMemoryEntries);
+    std::vector<std::string> stringKeys(numMemoryEntries);
+
+    for (std::size_t i{ 0 }; i < numMemoryEntries; ++i)
+    {
+        integerKeys[i] = i;
+        stringKeys[i] = "benchmark/cache/key/" + std::to_string(i);
+    }
+
+    std::cout << "\n  ],\n"
+        << "  \"memory\": [";
+
+    printMemoryResult("LRUCache", "size_t",
+        benchmarkMemory<pluto::LRUCache<std::size_t, std::size_t>>(integerKeys), true);
+    printMemoryResult("PreallocatedLRUCache", "size_t",
+        benchmarkMemory<PreallocatedLRUCache<std::size_t, std::size_t>>(integerKeys), false);
+    printMemoryResult("MapLRUCache", "size_t",
+        benchmarkMemory<MapLRUCache<std::size_t, std::size_t>>(integerKeys), false);
+    printMemoryResult("LRUCache", "string",
+        benchmarkMemory<pluto::LRUCache<std::string, std::size_t>>(stringKeys), false);
+    printMemoryResult("PreallocatedLRUCache", "string",
+        benchmarkMemory<PreallocatedLRUCache<std::string, std::size_t>>(stringKeys), false);
+    printMemoryResult("MapLRUCache", "string",
+        benchmarkMemory<MapLRUCache<std::string, std::size_t>>(stringKeys), false);
+
+    // Traces over a million keys for a cache of ten thousand. Scans as big as the cache come every
+    // 10% of the trace, and a loop over slightly more keys than fit defeats recency based policies.
+    const std::size_t numTraceKeys{ 1000000 };
+    const std::size_t traceCapacity{ 10000 };
+    const auto zipfTrace{ makeZipfTrace(numTraceKeys, numOps, 0.9) };
+
+    std::vector<std::size_t> loopTrace(numOps);
+    for (std::size_t i{ 0 }; i < numOps; ++i)
+    {
+        loopTrace[i] = i % (traceCapacity + (traceCapacity / 5));
+    }
+
+    std::cout << "\n  ],\n"
+        << "  \"hitRatios\": [";
+
+    printHitRatios("zipf", zipfTrace, traceCapacity, true);
+    printHitRatios("zipf with scans", addScans(zipfTrace, std::max<std::size_t>(numOps / 10, 1), traceCapacity), traceCapacity, false);
+    printHitRatios("loop", loopTrace, traceCapacity, false);
+
+    // The concurrent workload runs on a fixed number of entries, the trace is split between threads
+    const std::size_t numConcurrentEntries{ 100000 };
+    const auto concurrentTrace{ makeZipfTrace((numConcurrentEntries * 10), std::max(numOps, numThreads), 0.9) };
+
+    std::cout << "\n  ],\n"
+        << "  \"concurrent\": [";
+
+    {
+        pluto::SafeLRUCache<std::size_t, std::size_t> safeCache{ numConcurrentEntries };
+        printConcurrentResult("SafeLRUCache", numThreads,
+            benchmarkConcurrent(safeCache, numThreads, numConcurrentEntries, concurrentTrace), true);
+    }
+
+    {
+        pluto::SafeLRUCache<std::size_t, std::size_t> bufferedCache{ numConcurrentEntries, pluto::SafeLRUCacheReads::Buffered };
+        printConcurrentResult("SafeLRUCache (buffered reads)", numThreads,
+            benchmarkConcurrent(bufferedCache, numThreads, numConcurrentEntries, concurrentTrace), false);
+    }
+
+    {
+        pluto::SafeLRUCache<std::size_t, std::size_t, std::hash<std::size_t>, std::equal_to<std::size_t>, pluto::ClockPolicy> clockCache{ numConcurrentEntries };
+        printConcurrentResult("SafeLRUCache (CLOCK)", numThreads,
+            benchmarkConcurrent(clockCache, numThreads, numConcurrentEntries, concurrentTrace), false);
+    }
+
+    {
+        pluto::ShardedLRUCache<std::size_t, std::size_t> shardedCache{ numConcurrentEntries };
+        printConcurrentResult("ShardedLRUCache", numThreads,
+            benchmarkConcurrent(shardedCache, numThreads, numConcurrentEntries, concurrentTrace), false);
+    }
+
+    {
+        pluto::ShardedLRUCache<std::size_t, std::size_t> globalCache{ numConcurrentEntries, false, true };
+        printConcurrentResult("ShardedLRUCache (approximate global LRU)", numThreads,
+            benchmarkConcurrent(globalCache, numThreads, numConcurrentEntries, concurrentTrace), false);
+    }
+
+    std::cout << "\n  ]\n"
+        << "}\n";
+
+    return 0;
+}
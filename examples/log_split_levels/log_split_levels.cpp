@@ -7,25 +7,33 @@
 
 #include <Pluto/Logger.hpp>
 
-#define LOG_FATAL(x)    PLUTO_LOG_STREAM_FATAL("logs/logFatal.log", x)
-#define LOG_CRITICAL(x) PLUTO_LOG_STREAM_CRITICAL("logs/logCritical.log", x)
-#define LOG_ERROR(x)    PLUTO_LOG_STREAM_ERROR("logs/logError.log", x)
-#define LOG_WARNING(x)  PLUTO_LOG_STREAM_WARNING("logs/logWarning.log", x)
-#define LOG_NOTICE(x)   PLUTO_LOG_STREAM_NOTICE("logs/logNotice.log", x)
-#define LOG_INFO(x)     PLUTO_LOG_STREAM_INFO("logs/logInfo.log", x)
-#define LOG_DEBUG(x)    PLUTO_LOG_STREAM_DEBUG("logs/logDebug.log", x)
-#define LOG_TRACE(x)    PLUTO_LOG_STREAM_TRACE("logs/logTrace.log", x)
-#define LOG_VERBOSE(x)  PLUTO_LOG_STREAM_VERBOSE("logs/logVerbose.log", x)
+#define LOG_FILE "logs/logAll.log"
+
+#define LOG_FATAL(x)    PLUTO_LOG_STREAM_FATAL(LOG_FILE, x)
+#define LOG_CRITICAL(x) PLUTO_LOG_STREAM_CRITICAL(LOG_FILE, x)
+#define LOG_ERROR(x)    PLUTO_LOG_STREAM_ERROR(LOG_FILE, x)
+#define LOG_WARNING(x)  PLUTO_LOG_STREAM_WARNING(LOG_FILE, x)
+#define LOG_NOTICE(x)   PLUTO_LOG_STREAM_NOTICE(LOG_FILE, x)
+#define LOG_INFO(x)     PLUTO_LOG_STREAM_INFO(LOG_FILE, x)
+#define LOG_DEBUG(x)    PLUTO_LOG_STREAM_DEBUG(LOG_FILE, x)
+#define LOG_TRACE(x)    PLUTO_LOG_STREAM_TRACE(LOG_FILE, x)
+#define LOG_VERBOSE(x)  PLUTO_LOG_STREAM_VERBOSE(LOG_FILE, x)
 
 int main(int argc, char* argv[])
 {
-    pluto::Logger::getInstance().metaDataColumns(
-        pluto::Logger::MetaDataColumn::Timestamp,
-        pluto::Logger::MetaDataColumn::ProcessID,
-        pluto::Logger::MetaDataColumn::ThreadID,
-        pluto::Logger::MetaDataColumn::FileName,
-        pluto::Logger::MetaDataColumn::Line,
-        pluto::Logger::MetaDataColumn::Function);
+    // Every log goes to logAll.log, each is queued and rendered once however many routes it matches
+    pluto::Logger::getInstance()
+        .metaDataColumns(
+            pluto::Logger::MetaDataColumn::Timestamp,
+            pluto::Logger::MetaDataColumn::ProcessID,
+            pluto::Logger::MetaDataColumn::ThreadID,
+            pluto::Logger::MetaDataColumn::Level,
+            pluto::Logger::MetaDataColumn::FileName,
+            pluto::Logger::MetaDataColumn::Line,
+            pluto::Logger::MetaDataColumn::Function)
+        .route(LOG_FILE, pluto::Logger::Level::Error, "logs/logError.log")
+        .route(LOG_FILE, pluto::Logger::Level::Debug, "logs/logDebug.log")
+        .route(LOG_FILE, pluto::Logger::Level::Fatal, pluto::Logger::Output::Stderr);
 
     std::size_t numLogs{ 100 };
     for (std::size_t i{ 0 }; i < numLogs; ++i)
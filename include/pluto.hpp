@@ -9,13 +9,17 @@
 
 #include "pluto/compare.hpp"
 #include "pluto/container_utils.hpp"
+#include "pluto/eviction_policies.hpp"
+#include "pluto/expiry_policies.hpp"
 #include "pluto/filesystem.hpp"
 #include "pluto/iterator_utils.hpp"
 #include "pluto/locale.hpp"
 #include "pluto/logger.hpp"
 #include "pluto/lru_cache.hpp"
+#include "pluto/ordered_lru_cache.hpp"
 #include "pluto/range.hpp"
 #include "pluto/safe_lru_cache.hpp"
 #include "pluto/scope_exit_actions.hpp"
+#include "pluto/sharded_lru_cache.hpp"
 #include "pluto/stopwatch.hpp"
 #include "pluto/string_utils.hpp"
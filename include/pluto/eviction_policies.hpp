@@ -0,0 +1,1167 @@
+/*
+* Copyright (c) 2024 Stephen O Driscoll
+*
+* Distributed under the MIT License (See accompanying file LICENSE)
+* Official repository: https://github.com/Stephen-ODriscoll/PlutoUtils
+*/
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+// Eviction policies for pluto::LRUCache. The cache owns the entries and their memory,
+// a policy decides which entry is evicted next using the Hook each entry inherits.
+//
+// A policy provides:
+//  struct Hook                     Per-entry state derived from CacheHook, a base of the cache's nodes
+//  static concurrentHits()         True if access() only reads or stores atomics, so hits can run together
+//  static isResident(hook)         False if the entry's value was evicted but the policy remembers its key
+//  static supportsWeights()        True if the policy doesn't size itself by the capacity, so entries can
+//                                  weigh more than 1 and the capacity is a total weight rather than a count
+//  static maxRemembered(capacity)  The most keys the policy remembers at once, the cache pools nodes for them
+//  capacity(n)                     The cache's capacity changed
+//  insert(hook)                    A new entry was added
+//  revive(hook)                    A remembered key was added again, after erase() took it off the policy
+//  access(hook)                    An entry was hit
+//  victim()                        The entry to evict next, nullptr if there are none. Can update the policy.
+//  evict(hook)                     Evicts the hook victim() returned. True to remember its key, it must then
+//                                  stay a remembered key until the policy gives it up through forget().
+//  erase(hook)                     An entry was removed, or a remembered key is about to be revived
+//  forget()                        A remembered key the policy gave up to free, or nullptr. The cache
+//                                  frees them after each insert(), revive() and evict().
+//  clear()                         Forgets every entry, without touching them
+//  forEachOldestFirst(function)    Calls function with each entry from next to last evicted
+
+namespace pluto
+{
+    // The cache fills in the hash of the entry's key, which policies can use too
+    struct CacheHook
+    {
+        std::size_t hash;   // Cached so growing the table and comparing keys don't rehash
+    };
+
+    // Intrusive list of hooks with prev and next links, from most to least recently used
+    template<class HookT>
+    struct PolicyList
+    {
+        HookT*      head    { nullptr };    // Most recently used
+        HookT*      tail    { nullptr };    // Least recently used
+        std::size_t size    { 0 };
+
+        void pushFront(HookT& hook)
+        {
+            hook.prev = nullptr;
+            hook.next = head;
+
+            if (head != nullptr)
+            {
+                head->prev = &hook;
+            }
+            else
+            {
+                tail = &hook;
+            }
+
+            head = &hook;
+            ++size;
+        }
+
+        void unlink(HookT& hook)
+        {
+            if (hook.prev != nullptr)
+            {
+                hook.prev->next = hook.next;
+            }
+            else
+            {
+                head = hook.next;
+            }
+
+            if (hook.next != nullptr)
+            {
+                hook.next->prev = hook.prev;
+            }
+            else
+            {
+                tail = hook.prev;
+            }
+
+            --size;
+        }
+
+        void moveToFront(HookT& hook)
+        {
+            if (&hook != head)
+            {
+                unlink(hook);
+                pushFront(hook);
+            }
+        }
+
+        void clear()
+        {
+            head = nullptr;
+            tail = nullptr;
+            size = 0;
+        }
+
+        template<class FunctionT>
+        void forEachOldestFirst(FunctionT& function) const
+        {
+            for (auto hook{ tail }; hook != nullptr; hook = hook->prev)
+            {
+                function(*hook);
+            }
+        }
+    };
+
+    // Evicts the least recently used entry. Every hit moves the entry to the front of a list.
+    class LRUPolicy
+    {
+    public:
+        struct Hook : CacheHook
+        {
+            Hook*   prev;   // More recently used
+            Hook*   next;   // Less recently used
+        };
+
+    private:
+        PolicyList<Hook>    m_list  {};
+
+    public:
+        static constexpr bool concurrentHits()              { return false; }
+        static constexpr bool supportsWeights()             { return true; }
+        static constexpr bool isResident(const Hook&)       { return true; }
+        static constexpr std::size_t maxRemembered(const std::size_t) { return 0; }
+
+        void capacity(const std::size_t) {}
+
+        void insert(Hook& hook) { m_list.pushFront(hook); }
+        void revive(Hook& hook) { m_list.pushFront(hook); }
+        void access(Hook& hook) { m_list.moveToFront(hook); }
+
+        Hook* victim()  { return m_list.tail; }
+        Hook* forget()  { return nullptr; }
+
+        bool evict(Hook& hook)
+        {
+            m_list.unlink(hook);
+            return false;
+        }
+
+        void erase(Hook& hook)  { m_list.unlink(hook); }
+        void clear()            { m_list.clear(); }
+
+        template<class FunctionT>
+        void forEachOldestFirst(FunctionT function) const
+        {
+            m_list.forEachOldestFirst(function);
+        }
+    };
+
+    // Approximates LRU with one reference bit per entry. A hit only sets the bit, with a relaxed
+    // store that's skipped if it's already set. To evict, a hand sweeps the entries in insertion
+    // order, clearing set bits, and evicts the first entry whose bit is clear.
+    class ClockPolicy
+    {
+    public:
+        struct Hook : CacheHook
+        {
+            Hook*               prev;
+            Hook*               next;
+            std::atomic<bool>   referenced;
+        };
+
+    private:
+        Hook*   m_hand  { nullptr };    // Next entry to check, the entries form a ring
+
+    public:
+        static constexpr bool concurrentHits()              { return true; }
+        static constexpr bool supportsWeights()             { return true; }
+        static constexpr bool isResident(const Hook&)       { return true; }
+        static constexpr std::size_t maxRemembered(const std::size_t) { return 0; }
+
+        void capacity(const std::size_t) {}
+
+        void insert(Hook& hook) { linkBehindHand(hook); }
+        void revive(Hook& hook) { linkBehindHand(hook); }
+
+        void access(Hook& hook)
+        {
+            if (!hook.referenced.load(std::memory_order_relaxed))
+            {
+                hook.referenced.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        Hook* victim()
+        {
+            if (m_hand != nullptr)
+            {
+                while (m_hand->referenced.load(std::memory_order_relaxed))
+                {
+                    m_hand->referenced.store(false, std::memory_order_relaxed);
+                    m_hand = m_hand->next;
+                }
+            }
+
+            return m_hand;
+        }
+
+        Hook* forget() { return nullptr; }
+
+        bool evict(Hook& hook)
+        {
+            erase(hook);
+            return false;
+        }
+
+        void erase(Hook& hook)
+        {
+            if (hook.next == &hook)
+            {
+                m_hand = nullptr;
+                return;
+            }
+
+            if (m_hand == &hook)
+            {
+                m_hand = hook.next;
+            }
+
+            hook.prev->next = hook.next;
+            hook.next->prev = hook.prev;
+        }
+
+        void clear() { m_hand = nullptr; }
+
+        template<class FunctionT>
+        void forEachOldestFirst(FunctionT function) const
+        {
+            if (m_hand != nullptr)
+            {
+                auto hook{ m_hand };
+                do
+                {
+                    function(*hook);
+                    hook = hook->next;
+                }
+                while (hook != m_hand);
+            }
+        }
+
+    private:
+        // Behind the hand is the last place it checks
+        void linkBehindHand(Hook& hook)
+        {
+            hook.referenced.store(false, std::memory_order_relaxed);
+
+            if (m_hand == nullptr)
+            {
+                hook.prev = &hook;
+                hook.next = &hook;
+                m_hand = &hook;
+                return;
+            }
+
+            hook.next = m_hand;
+            hook.prev = m_hand->prev;
+            m_hand->prev->next = &hook;
+            m_hand->prev = &hook;
+        }
+    };
+
+    // CLOCK-Pro (Jiang, Chen and Zhang, 2005) splits entries into hot and cold by how recently
+    // they were reused rather than used. New entries start cold and only cold entries are evicted,
+    // so a scan of keys used once can't push out a hot working set. Evicted cold entries keep their
+    // key for a test period, and an entry added again during it comes back hot and grows the share
+    // of the cache given to cold entries. Hits set a reference bit like CLOCK.
+    //
+    // Each entry sits on one ring swept by three hands: the hot hand cools hot entries that weren't
+    // referenced, the cold hand evicts or promotes cold entries and the test hand ends test periods.
+    // At most the capacity in evicted keys are remembered, so there are up to twice as many entries.
+    class ClockProPolicy
+    {
+    public:
+        struct Hook : CacheHook
+        {
+            Hook*               prev;
+            Hook*               next;
+            std::atomic<bool>   referenced;
+            unsigned char       status;
+        };
+
+    private:
+        enum Status : unsigned char
+        {
+            Hot,
+            Cold,
+            Test    // Evicted, only the key is kept
+        };
+
+        Hook*       m_handHot       { nullptr };
+        Hook*       m_handCold      { nullptr };
+        Hook*       m_handTest      { nullptr };
+        Hook*       m_forgotten     { nullptr };    // Ended test periods, linked through next
+        std::size_t m_capacity      { 0 };
+        std::size_t m_coldTarget    { 0 };          // Entries kept cold, adapts to the workload
+        std::size_t m_numHot        { 0 };
+        std::size_t m_numCold       { 0 };
+        std::size_t m_numTest       { 0 };
+
+    public:
+        static constexpr bool concurrentHits()                  { return true; }
+        static constexpr bool supportsWeights()                 { return false; }
+        static constexpr bool isResident(const Hook& hook)      { return (hook.status != Test); }
+        static constexpr std::size_t maxRemembered(const std::size_t capacity) { return capacity; }
+
+        // Starts with every entry cold, like CLOCK, until reused entries show there's a working set
+        void capacity(const std::size_t newCapacity)
+        {
+            m_coldTarget = (m_capacity == 0) ? newCapacity : std::min(m_coldTarget, newCapacity);
+            m_capacity = newCapacity;
+        }
+
+        void insert(Hook& hook)
+        {
+            hook.status = Cold;
+            link(hook);
+            ++m_numCold;
+        }
+
+        // Reused within its test period, it would have been a hit with more space for cold entries
+        void revive(Hook& hook)
+        {
+            m_coldTarget = std::min(m_coldTarget + 1, m_capacity);
+
+            hook.status = Hot;
+            link(hook);
+            ++m_numHot;
+        }
+
+        void access(Hook& hook)
+        {
+            if (!hook.referenced.load(std::memory_order_relaxed))
+            {
+                hook.referenced.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        Hook* victim()
+        {
+            if ((m_numHot + m_numCold) == 0)
+            {
+                return nullptr;
+            }
+
+            for (;;)
+            {
+                // Keep a cold entry to evict and the hot entries within their share
+                while (m_numCold == 0 || hotTarget() < m_numHot)
+                {
+                    runHandHot();
+                }
+
+                auto& hook{ *m_handCold };
+                if (hook.status == Cold)
+                {
+                    if (!hook.referenced.load(std::memory_order_relaxed))
+                    {
+                        return &hook;
+                    }
+
+                    // Reused while cold
+                    hook.referenced.store(false, std::memory_order_relaxed);
+                    hook.status = Hot;
+                    --m_numCold;
+                    ++m_numHot;
+                }
+
+                m_handCold = m_handCold->next;
+            }
+        }
+
+        bool evict(Hook& hook)
+        {
+            hook.status = Test;
+            --m_numCold;
+            ++m_numTest;
+
+            m_handCold = hook.next;
+            while (m_capacity < m_numTest)
+            {
+                runHandTest();
+            }
+
+            return true;
+        }
+
+        void erase(Hook& hook)
+        {
+            switch (hook.status)
+            {
+            case Hot:   --m_numHot;     break;
+            case Cold:  --m_numCold;    break;
+            default:    --m_numTest;    break;
+            }
+
+            unlink(hook);
+        }
+
+        Hook* forget()
+        {
+            const auto hook{ m_forgotten };
+            if (hook != nullptr)
+            {
+                m_forgotten = hook->next;
+            }
+
+            return hook;
+        }
+
+        void clear()
+        {
+            m_handHot = nullptr;
+            m_handCold = nullptr;
+            m_handTest = nullptr;
+            m_forgotten = nullptr;
+            m_coldTarget = m_capacity;
+            m_numHot = 0;
+            m_numCold = 0;
+            m_numTest = 0;
+        }
+
+        // Oldest first from the hot hand, which new entries are linked behind
+        template<class FunctionT>
+        void forEachOldestFirst(FunctionT function) const
+        {
+            if (m_handHot != nullptr)
+            {
+                auto hook{ m_handHot };
+                do
+                {
+                    if (isResident(*hook))
+                    {
+                        function(*hook);
+                    }
+
+                    hook = hook->next;
+                }
+                while (hook != m_handHot);
+            }
+        }
+
+    private:
+        // At least one entry is kept cold so there's always one to evict
+        std::size_t hotTarget() const
+        {
+            return m_capacity - std::min(std::max<std::size_t>(m_coldTarget, 1), m_capacity);
+        }
+
+        void runHandHot()
+        {
+            // The test hand stays ahead of the hot hand
+            if (m_handHot == m_handTest)
+            {
+                runHandTest();
+            }
+
+            auto& hook{ *m_handHot };
+            if (hook.status == Hot)
+            {
+                if (hook.referenced.load(std::memory_order_relaxed))
+                {
+                    hook.referenced.store(false, std::memory_order_relaxed);
+                }
+                else
+                {
+                    hook.status = Cold;
+                    --m_numHot;
+                    ++m_numCold;
+                }
+            }
+
+            m_handHot = m_handHot->next;
+        }
+
+        // Ends the test period of the entry under the hand, the cold share shrinks as it wasn't reused
+        void runHandTest()
+        {
+            auto& hook{ *m_handTest };
+            if (hook.status == Test)
+            {
+                --m_numTest;
+                unlink(hook);
+
+                hook.next = m_forgotten;
+                m_forgotten = &hook;
+
+                if (1 < m_coldTarget)
+                {
+                    --m_coldTarget;
+                }
+            }
+
+            if (m_handTest != nullptr)
+            {
+                m_handTest = m_handTest->next;
+            }
+        }
+
+        // New entries go behind the hot hand, the last place it reaches
+        void link(Hook& hook)
+        {
+            hook.referenced.store(false, std::memory_order_relaxed);
+
+            if (m_handHot == nullptr)
+            {
+                hook.prev = &hook;
+                hook.next = &hook;
+                m_handHot = &hook;
+                m_handCold = &hook;
+                m_handTest = &hook;
+                return;
+            }
+
+            hook.next = m_handHot;
+            hook.prev = m_handHot->prev;
+            m_handHot->prev->next = &hook;
+            m_handHot->prev = &hook;
+
+            if (m_handCold == m_handHot)
+            {
+                m_handCold = &hook;
+            }
+        }
+
+        // Hands on the hook step back, so they move on to the hook after it next
+        void unlink(Hook& hook)
+        {
+            if (hook.next == &hook)
+            {
+                m_handHot = nullptr;
+                m_handCold = nullptr;
+                m_handTest = nullptr;
+                return;
+            }
+
+            if (m_handHot == &hook)
+            {
+                m_handHot = hook.prev;
+            }
+
+            if (m_handCold == &hook)
+            {
+                m_handCold = hook.prev;
+            }
+
+            if (m_handTest == &hook)
+            {
+                m_handTest = hook.prev;
+            }
+
+            hook.prev->next = hook.next;
+            hook.next->prev = hook.prev;
+        }
+    };
+
+    // Estimates how often each hash was seen with a count-min sketch of 4 bit counters, 16 to a word.
+    // Each hash increments one counter in each of four words and its frequency is the smallest of them.
+    // Once there have been ten increments per counted entry every counter is halved, so old
+    // popularity fades and the estimate follows recent use.
+    class FrequencySketch
+    {
+        std::vector<std::uint64_t>  m_table         {};
+        std::size_t                 m_mask          { 0 };
+        std::size_t                 m_sampleSize    { 0 };
+        std::size_t                 m_numIncrements { 0 };
+
+    public:
+        static constexpr unsigned maxFrequency() { return 15; }
+
+        // Sized for one word per entry, so the counters keep their accuracy as the cache grows
+        void capacity(const std::size_t numEntries)
+        {
+            std::size_t numWords{ 1 };
+            while (numWords < numEntries)
+            {
+                numWords *= 2;
+            }
+
+            m_table.assign(numWords, 0);
+            m_mask = numWords - 1;
+            m_sampleSize = 10 * std::max<std::size_t>(numEntries, 1);
+            m_numIncrements = 0;
+        }
+
+        unsigned frequency(const std::size_t hash) const
+        {
+            if (m_table.empty())
+            {
+                return 0;
+            }
+
+            auto frequency{ maxFrequency() };
+            for (unsigned row{ 0 }; row < 4; ++row)
+            {
+                const auto rowHash{ mix(hash, row) };
+                frequency = std::min(frequency, static_cast<unsigned>((m_table[rowHash & m_mask] >> shift(rowHash)) & 0xF));
+            }
+
+            return frequency;
+        }
+
+        void increment(const std::size_t hash)
+        {
+            if (m_table.empty())
+            {
+                return;
+            }
+
+            auto isIncremented{ false };
+            for (unsigned row{ 0 }; row < 4; ++row)
+            {
+                const auto rowHash{ mix(hash, row) };
+                auto& word{ m_table[rowHash & m_mask] };
+                const auto counterShift{ shift(rowHash) };
+
+                if (((word >> counterShift) & 0xF) < maxFrequency())
+                {
+                    word += (std::uint64_t{ 1 } << counterShift);
+                    isIncremented = true;
+                }
+            }
+
+            if (isIncremented && m_sampleSize <= ++m_numIncrements)
+            {
+                age();
+            }
+        }
+
+    private:
+        // Each row mixes the hash differently, so hashes that collide in one row rarely collide in all
+        static std::uint64_t mix(const std::size_t hash, const unsigned row)
+        {
+            static const std::uint64_t seeds[]{
+                0xC3A5C85C97CB3127ull, 0xB492B66FBE98F273ull, 0x9AE16A3B2F90404Full, 0xCBF29CE484222325ull };
+
+            auto mixed{ (static_cast<std::uint64_t>(hash) + seeds[row]) * 0x9E3779B97F4A7C15ull };
+            return mixed ^ (mixed >> 32);
+        }
+
+        // Picks one of the word's 16 counters with the hash's top bits, the low bits picked the word
+        static unsigned shift(const std::uint64_t rowHash)
+        {
+            return static_cast<unsigned>(rowHash >> 60) * 4;
+        }
+
+        void age()
+        {
+            for (auto& word : m_table)
+            {
+                word = (word >> 1) & 0x7777777777777777ull;
+            }
+
+            m_numIncrements /= 2;
+        }
+    };
+
+    // W-TinyLFU (Einziger, Friedman and Manes, 2017). New entries go through a small LRU window
+    // of 1% of the capacity into a segmented LRU main area, split into probation and a protected
+    // segment of 80% of it that entries hit in probation move up to. When the window overflows into
+    // a full main area, its least recently used entry is only admitted if a frequency sketch says
+    // it's used more often than the main area's victim. Keys seen once, like a scan, mostly stay in
+    // the window and can't push frequently used entries out.
+    class TinyLFUPolicy
+    {
+    public:
+        struct Hook : CacheHook
+        {
+            Hook*           prev;
+            Hook*           next;
+            unsigned char   segment;
+        };
+
+    private:
+        enum Segment : unsigned char
+        {
+            Window,
+            Probation,
+            Protected
+        };
+
+        PolicyList<Hook>    m_window        {};
+        PolicyList<Hook>    m_probation     {};
+        PolicyList<Hook>    m_protected     {};
+        std::size_t         m_maxWindow     { 0 };
+        std::size_t         m_maxProtected  { 0 };
+        FrequencySketch     m_sketch        {};
+
+    public:
+        static constexpr bool concurrentHits()              { return false; }
+        static constexpr bool supportsWeights()             { return false; }
+        static constexpr bool isResident(const Hook&)       { return true; }
+        static constexpr std::size_t maxRemembered(const std::size_t) { return 0; }
+
+        void capacity(const std::size_t newCapacity)
+        {
+            m_maxWindow = std::max<std::size_t>(newCapacity / 100, 1);
+            m_maxProtected = ((newCapacity - std::min(m_maxWindow, newCapacity)) * 4) / 5;
+            m_sketch.capacity(newCapacity);
+
+            while (m_maxWindow < m_window.size)
+            {
+                moveToProbation(*m_window.tail);
+            }
+        }
+
+        void insert(Hook& hook)
+        {
+            m_sketch.increment(hook.hash);
+            addToWindow(hook);
+        }
+
+        void revive(Hook& hook) { insert(hook); }
+
+        void access(Hook& hook)
+        {
+            m_sketch.increment(hook.hash);
+
+            switch (hook.segment)
+            {
+            case Window:
+                m_window.moveToFront(hook);
+                break;
+
+            case Probation:
+                m_probation.unlink(hook);
+                hook.segment = Protected;
+                m_protected.pushFront(hook);
+
+                // Protected is full, its least recently used entry goes back on probation
+                if (m_maxProtected < m_protected.size)
+                {
+                    auto& demoted{ *m_protected.tail };
+                    m_protected.unlink(demoted);
+                    demoted.segment = Probation;
+                    m_probation.pushFront(demoted);
+                }
+                break;
+
+            default:
+                m_protected.moveToFront(hook);
+                break;
+            }
+        }
+
+        // With the window full, its oldest entry competes with the main area's victim for a place
+        Hook* victim()
+        {
+            const auto mainVictim{ (m_probation.tail != nullptr) ? m_probation.tail : m_protected.tail };
+            if (mainVictim == nullptr)
+            {
+                return m_window.tail;
+            }
+
+            const auto candidate{ (m_maxWindow <= m_window.size) ? m_window.tail : nullptr };
+            if (candidate == nullptr)
+            {
+                return mainVictim;
+            }
+
+            return (m_sketch.frequency(mainVictim->hash) < m_sketch.frequency(candidate->hash)) ? mainVictim : candidate;
+        }
+
+        Hook* forget() { return nullptr; }
+
+        // If the main area lost an entry, the window's candidate won and takes its place
+        bool evict(Hook& hook)
+        {
+            const auto isCandidateAdmitted{ hook.segment != Window };
+            erase(hook);
+
+            if (isCandidateAdmitted && m_maxWindow <= m_window.size)
+            {
+                moveToProbation(*m_window.tail);
+            }
+
+            return false;
+        }
+
+        void erase(Hook& hook)
+        {
+            listOf(hook).unlink(hook);
+        }
+
+        // The frequencies are kept, they describe the workload rather than the entries
+        void clear()
+        {
+            m_window.clear();
+            m_probation.clear();
+            m_protected.clear();
+        }
+
+        template<class FunctionT>
+        void forEachOldestFirst(FunctionT function) const
+        {
+            m_probation.forEachOldestFirst(function);
+            m_protected.forEachOldestFirst(function);
+            m_window.forEachOldestFirst(function);
+        }
+
+    private:
+        PolicyList<Hook>& listOf(const Hook& hook)
+        {
+            switch (hook.segment)
+            {
+            case Window:    return m_window;
+            case Probation: return m_probation;
+            default:        return m_protected;
+            }
+        }
+
+        void addToWindow(Hook& hook)
+        {
+            hook.segment = Window;
+            m_window.pushFront(hook);
+
+            // Room to spare in the cache, the window's oldest entry moves to the main area unopposed
+            if (m_maxWindow < m_window.size)
+            {
+                moveToProbation(*m_window.tail);
+            }
+        }
+
+        void moveToProbation(Hook& hook)
+        {
+            m_window.unlink(hook);
+            hook.segment = Probation;
+            m_probation.pushFront(hook);
+        }
+    };
+
+    // ARC (Megiddo and Modha, 2003). Entries used once are kept in T1 and entries used again in T2,
+    // both LRU. Evicted keys are remembered in B1 and B2, and a remembered key added again shows which
+    // list deserved more room: one from B1 grows T1's target share, one from B2 shrinks it. The
+    // balance between recency and frequency adapts without tuning, and a scan only churns T1.
+    // T1 and B1 hold at most the capacity between them, and all four hold at most twice the capacity.
+    class ARCPolicy
+    {
+    public:
+        struct Hook : CacheHook
+        {
+            Hook*           prev;
+            Hook*           next;
+            unsigned char   list;
+        };
+
+    private:
+        enum ListID : unsigned char
+        {
+            T1,
+            T2,
+            B1,     // Keys evicted from T1
+            B2      // Keys evicted from T2
+        };
+
+        PolicyList<Hook>    m_t1                {};
+        PolicyList<Hook>    m_t2                {};
+        PolicyList<Hook>    m_b1                {};
+        PolicyList<Hook>    m_b2                {};
+        Hook*               m_forgotten         { nullptr };    // Linked through next
+        std::size_t         m_capacity          { 0 };
+        std::size_t         m_target            { 0 };          // T1's share of the capacity
+        bool                m_isRevivingFromB2  { false };
+
+    public:
+        static constexpr bool concurrentHits()                  { return false; }
+        static constexpr bool supportsWeights()                 { return false; }
+        static constexpr bool isResident(const Hook& hook)      { return (hook.list == T1 || hook.list == T2); }
+
+        // B1 and B2 hold at most the capacity while the cache is full, and one more once an insert
+        // has evicted but the new entry hasn't joined T1 yet
+        static constexpr std::size_t maxRemembered(const std::size_t capacity) { return (capacity + 1); }
+
+        void capacity(const std::size_t newCapacity)
+        {
+            m_capacity = newCapacity;
+            m_target = std::min(m_target, m_capacity);
+        }
+
+        void insert(Hook& hook)
+        {
+            hook.list = T1;
+            m_t1.pushFront(hook);
+            m_isRevivingFromB2 = false;
+            forgetOverCapacity();
+        }
+
+        void revive(Hook& hook)
+        {
+            hook.list = T2;
+            m_t2.pushFront(hook);
+            m_isRevivingFromB2 = false;
+            forgetOverCapacity();
+        }
+
+        void access(Hook& hook)
+        {
+            if (hook.list == T1)
+            {
+                m_t1.unlink(hook);
+                hook.list = T2;
+                m_t2.pushFront(hook);
+            }
+            else
+            {
+                m_t2.moveToFront(hook);
+            }
+        }
+
+        // T1 gives up an entry once it's over its target. A key coming back from B2 wants T2 to keep
+        // its entries, so T1 gives one up at its target too.
+        Hook* victim()
+        {
+            if (m_t1.size != 0 && (m_target < m_t1.size || (m_isRevivingFromB2 && m_target == m_t1.size) || m_t2.size == 0))
+            {
+                return m_t1.tail;
+            }
+
+            return m_t2.tail;
+        }
+
+        bool evict(Hook& hook)
+        {
+            if (hook.list == T1)
+            {
+                m_t1.unlink(hook);
+                hook.list = B1;
+                m_b1.pushFront(hook);
+            }
+            else
+            {
+                m_t2.unlink(hook);
+                hook.list = B2;
+                m_b2.pushFront(hook);
+            }
+
+            forgetOverCapacity();
+            return true;
+        }
+
+        // A remembered key is only erased before it's revived, which is when ARC adapts
+        void erase(Hook& hook)
+        {
+            switch (hook.list)
+            {
+            case T1:
+                m_t1.unlink(hook);
+                break;
+
+            case T2:
+                m_t2.unlink(hook);
+                break;
+
+            case B1:
+                m_target = std::min(m_target + std::max<std::size_t>(m_b2.size / m_b1.size, 1), m_capacity);
+                m_b1.unlink(hook);
+                break;
+
+            default:
+                m_target -= std::min(m_target, std::max<std::size_t>(m_b1.size / m_b2.size, 1));
+                m_isRevivingFromB2 = true;
+                m_b2.unlink(hook);
+                break;
+            }
+        }
+
+        Hook* forget()
+        {
+            const auto hook{ m_forgotten };
+            if (hook != nullptr)
+            {
+                m_forgotten = hook->next;
+            }
+
+            return hook;
+        }
+
+        void clear()
+        {
+            m_t1.clear();
+            m_t2.clear();
+            m_b1.clear();
+            m_b2.clear();
+            m_forgotten = nullptr;
+            m_target = 0;
+            m_isRevivingFromB2 = false;
+        }
+
+        template<class FunctionT>
+        void forEachOldestFirst(FunctionT function) const
+        {
+            m_t1.forEachOldestFirst(function);
+            m_t2.forEachOldestFirst(function);
+        }
+
+    private:
+        void forgetOverCapacity()
+        {
+            while (m_b1.size != 0 && m_capacity < (m_t1.size + m_b1.size))
+            {
+                forgetOldest(m_b1);
+            }
+
+            while ((m_b1.size + m_b2.size) != 0 && (m_capacity * 2) < (m_t1.size + m_t2.size + m_b1.size + m_b2.size))
+            {
+                forgetOldest((m_b2.size != 0) ? m_b2 : m_b1);
+            }
+        }
+
+        void forgetOldest(PolicyList<Hook>& list)
+        {
+            auto& hook{ *list.tail };
+            list.unlink(hook);
+
+            hook.next = m_forgotten;
+            m_forgotten = &hook;
+        }
+    };
+
+    // 2Q (Johnson and Shasha, 1994). New entries wait in a FIFO queue of a quarter of the capacity
+    // and leave without being promoted, however often they're hit there. Their keys are remembered
+    // in a second FIFO of half the capacity, and only a key added again while remembered joins the
+    // main LRU list. Entries used once, like a scan, never reach the main list.
+    class TwoQueuePolicy
+    {
+    public:
+        struct Hook : CacheHook
+        {
+            Hook*           prev;
+            Hook*           next;
+            unsigned char   queue;
+        };
+
+    private:
+        enum Queue : unsigned char
+        {
+            In,     // FIFO of new entries
+            Out,    // FIFO of keys evicted from In
+            Main    // LRU of entries added again after leaving In
+        };
+
+        PolicyList<Hook>    m_in        {};
+        PolicyList<Hook>    m_out       {};
+        PolicyList<Hook>    m_main      {};
+        Hook*               m_forgotten { nullptr };    // Linked through next
+        std::size_t         m_maxIn     { 1 };
+        std::size_t         m_maxOut    { 1 };
+
+    public:
+        static constexpr bool concurrentHits()                  { return false; }
+        static constexpr bool supportsWeights()                 { return false; }
+        static constexpr bool isResident(const Hook& hook)      { return (hook.queue != Out); }
+        static constexpr std::size_t maxRemembered(const std::size_t capacity) { return std::max<std::size_t>(capacity / 2, 1); }
+
+        void capacity(const std::size_t newCapacity)
+        {
+            m_maxIn = std::max<std::size_t>(newCapacity / 4, 1);
+            m_maxOut = std::max<std::size_t>(newCapacity / 2, 1);
+        }
+
+        void insert(Hook& hook)
+        {
+            hook.queue = In;
+            m_in.pushFront(hook);
+        }
+
+        void revive(Hook& hook)
+        {
+            hook.queue = Main;
+            m_main.pushFront(hook);
+        }
+
+        // Hits in the In queue are often the same burst of use, they don't count
+        void access(Hook& hook)
+        {
+            if (hook.queue == Main)
+            {
+                m_main.moveToFront(hook);
+            }
+        }
+
+        Hook* victim()
+        {
+            if (m_in.size != 0 && (m_maxIn < m_in.size || m_main.size == 0))
+            {
+                return m_in.tail;
+            }
+
+            return m_main.tail;
+        }
+
+        bool evict(Hook& hook)
+        {
+            if (hook.queue == Main)
+            {
+                m_main.unlink(hook);
+                return false;
+            }
+
+            m_in.unlink(hook);
+            hook.queue = Out;
+            m_out.pushFront(hook);
+
+            while (m_maxOut < m_out.size)
+            {
+                auto& forgotten{ *m_out.tail };
+                m_out.unlink(forgotten);
+
+                forgotten.next = m_forgotten;
+                m_forgotten = &forgotten;
+            }
+
+            return true;
+        }
+
+        void erase(Hook& hook)
+        {
+            switch (hook.queue)
+            {
+            case In:    m_in.unlink(hook);      break;
+            case Out:   m_out.unlink(hook);     break;
+            default:    m_main.unlink(hook);    break;
+            }
+        }
+
+        Hook* forget()
+        {
+            const auto hook{ m_forgotten };
+            if (hook != nullptr)
+            {
+                m_forgotten = hook->next;
+            }
+
+            return hook;
+        }
+
+        void clear()
+        {
+            m_in.clear();
+            m_out.clear();
+            m_main.clear();
+            m_forgotten = nullptr;
+        }
+
+        template<class FunctionT>
+        void forEachOldestFirst(FunctionT function) const
+        {
+            m_in.forEachOldestFirst(function);
+            m_main.forEachOldestFirst(function);
+        }
+    };
+}
@@ -0,0 +1,315 @@
+/*
+* Copyright (c) 2024 Stephen O Driscoll
+*
+* Distributed under the MIT License (See accompanying file LICENSE)
+* Official repository: https://github.com/Stephen-ODriscoll/PlutoUtils
+*/
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+// Expiry policies for pluto::LRUCache. Each entry inherits the policy's Hook, which holds
+// when it expires. Times are nanoseconds since the clock's epoch, and 0 when the cache
+// didn't need to read the clock.
+//
+// A policy provides:
+//  struct Hook                     Per-entry state, a base of the cache's nodes
+//  DurationType                    The type of a time to live
+//  static enabled()                False if entries never expire, so the cache never reads the clock
+//  timeToLive()                    The time to live of entries inserted without one, zero if they don't expire
+//  now()                           The current time
+//  hasTimers()                     True if any entry can expire
+//  timer(now, timeToLive)          A Hook for an entry added at now, a zero time to live never expires
+//  schedule(hook, timer)           An entry was added or replaced with the expiry in timer
+//  unschedule(hook)                An entry was removed or evicted, does nothing if it has no timer
+//  access(hook, now)               An entry was hit
+//  isTimed(hook)                   True if the entry can expire
+//  isExpired(hook, now)            True if the entry expired at or before now
+//  advance(now, function)          Calls function with entries that expired, after unscheduling them
+//  clear()                         Forgets every timer, without touching the entries
+
+namespace pluto
+{
+    // Entries never expire. The hook is empty, so nodes are no bigger for it.
+    class NoExpiry
+    {
+    public:
+        struct Hook {};
+
+        typedef std::chrono::nanoseconds DurationType;
+
+        static constexpr bool enabled() { return false; }
+
+        DurationType timeToLive()   const   { return DurationType{ 0 }; }
+        std::int64_t now()          const   { return 0; }
+        bool hasTimers()            const   { return false; }
+
+        Hook timer(const std::int64_t, const DurationType) const { return Hook{}; }
+
+        void schedule(Hook&, const Hook&) {}
+        void unschedule(Hook&) {}
+        void access(Hook&, const std::int64_t) {}
+
+        bool isTimed(const Hook&)                           const   { return false; }
+        bool isExpired(const Hook&, const std::int64_t)     const   { return false; }
+
+        template<class FunctionT>
+        void advance(const std::int64_t, FunctionT&&) {}
+
+        void clear() {}
+    };
+
+    // Expires each entry after its own time to live, or after the default one. With expire after
+    // access, every hit starts the entry's time to live again.
+    //
+    // Expired entries are reclaimed by a hierarchical timing wheel (Varghese and Lauck, 1987), so the
+    // cost is O(1) amortized per entry instead of a scan. It has six levels of 64 buckets, the first
+    // bucket spans about a millisecond and each level's buckets span the whole level below. An entry
+    // sits in the lowest level that reaches its expiry and moves down a level each time its bucket
+    // comes up, and is reclaimed by the first advance a millisecond or so after it expires. Lookups
+    // still compare the exact expiry, so an entry that hasn't been reclaimed yet is never returned.
+    template<class ClockT = std::chrono::steady_clock>
+    class TimerWheelExpiry
+    {
+    public:
+        struct Hook
+        {
+            Hook*           timerNext;
+            Hook**          timerLink;      // Whichever pointer points to this, nullptr if not scheduled
+            std::int64_t    expiry;
+            std::int64_t    timeToLive;     // Zero if the entry doesn't expire
+        };
+
+        typedef ClockT ClockType;
+        typedef std::chrono::nanoseconds DurationType;
+
+    private:
+        static constexpr unsigned numLevels     { 6 };
+        static constexpr unsigned bucketBits    { 6 };      // 64 buckets per level
+        static constexpr unsigned tickBits      { 20 };     // First level's buckets span 2^20ns
+
+        static constexpr std::int64_t numBuckets() { return std::int64_t{ 1 } << bucketBits; }
+
+        std::vector<Hook*>  m_buckets           {};         // Allocated with the first timer
+        std::int64_t        m_time              { 0 };      // Last time the wheel advanced to
+        std::size_t         m_numTimers         { 0 };
+        DurationType        m_timeToLive        { 0 };
+        bool                m_expireAfterAccess { false };
+
+    public:
+        static constexpr bool enabled() { return true; }
+
+        TimerWheelExpiry() {}
+
+        // Copies only the settings, the timers belong to the entries of the cache copied from
+        TimerWheelExpiry(const TimerWheelExpiry& other) :
+            m_timeToLive        { other.m_timeToLive },
+            m_expireAfterAccess { other.m_expireAfterAccess } {}
+
+        TimerWheelExpiry(TimerWheelExpiry&& other)
+        {
+            *this = std::move(other);
+        }
+
+        TimerWheelExpiry& operator=(const TimerWheelExpiry& other)
+        {
+            m_timeToLive = other.m_timeToLive;
+            m_expireAfterAccess = other.m_expireAfterAccess;
+            return *this;
+        }
+
+        // Takes the timers too. Buckets are only ever moved, so the links into them stay valid.
+        TimerWheelExpiry& operator=(TimerWheelExpiry&& other)
+        {
+            if (this != &other)
+            {
+                m_buckets = std::move(other.m_buckets);
+                m_time = other.m_time;
+                m_numTimers = other.m_numTimers;
+                m_timeToLive = other.m_timeToLive;
+                m_expireAfterAccess = other.m_expireAfterAccess;
+
+                other.m_buckets.clear();
+                other.m_numTimers = 0;
+            }
+
+            return *this;
+        }
+
+        DurationType timeToLive()   const   { return m_timeToLive; }
+        bool expireAfterAccess()    const   { return m_expireAfterAccess; }
+        bool hasTimers()            const   { return (m_numTimers != 0); }
+
+        void timeToLive(const DurationType timeToLive)          { m_timeToLive = timeToLive; }
+        void expireAfterAccess(const bool expireAfterAccess)    { m_expireAfterAccess = expireAfterAccess; }
+
+        std::int64_t now() const
+        {
+            return static_cast<std::int64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(ClockType::now().time_since_epoch()).count());
+        }
+
+        Hook timer(const std::int64_t now, const DurationType timeToLive) const
+        {
+            Hook hook{};
+            hook.timeToLive = static_cast<std::int64_t>(timeToLive.count());
+            hook.expiry = now + hook.timeToLive;
+            return hook;
+        }
+
+        void schedule(Hook& hook, const Hook& timer)
+        {
+            unschedule(hook);
+            hook.expiry = timer.expiry;
+            hook.timeToLive = timer.timeToLive;
+
+            if (isTimed(hook))
+            {
+                link(hook);
+            }
+        }
+
+        void unschedule(Hook& hook)
+        {
+            if (hook.timerLink != nullptr)
+            {
+                unlink(hook);
+            }
+        }
+
+        void access(Hook& hook, const std::int64_t now)
+        {
+            if (m_expireAfterAccess && isTimed(hook))
+            {
+                unlink(hook);
+                hook.expiry = now + hook.timeToLive;
+                link(hook);
+            }
+        }
+
+        bool isTimed(const Hook& hook)                              const   { return (hook.timeToLive != 0); }
+        bool isExpired(const Hook& hook, const std::int64_t now)    const   { return (isTimed(hook) && hook.expiry <= now); }
+
+        // Only the buckets whose tick has come up since the last advance are visited, a level's
+        // tick only moves when the level below it wraps
+        template<class FunctionT>
+        void advance(const std::int64_t now, FunctionT&& function)
+        {
+            if (m_numTimers == 0 || now <= m_time)
+            {
+                m_time = (m_numTimers == 0) ? now : m_time;
+                return;
+            }
+
+            const auto previousTicks{ m_time >> tickBits };
+            const auto currentTicks{ now >> tickBits };
+            m_time = now;
+
+            for (unsigned level{ 0 }; level < numLevels; ++level)
+            {
+                const auto shift{ level * bucketBits };
+                const auto previous{ previousTicks >> shift };
+                const auto current{ currentTicks >> shift };
+                if (previous == current)
+                {
+                    break;
+                }
+
+                const auto last{ std::min(current, previous + numBuckets()) };
+                for (auto tick{ previous + 1 }; tick <= last; ++tick)
+                {
+                    expireBucket(m_buckets[(level * numBuckets()) + (tick & (numBuckets() - 1))], function);
+                }
+            }
+        }
+
+        void clear()
+        {
+            std::fill(m_buckets.begin(), m_buckets.end(), nullptr);
+            m_numTimers = 0;
+        }
+
+    private:
+        // Bucket ticks come up when the wheel reaches them, so an entry waits for the first
+        // tick after its expiry. It goes in the lowest level where that tick is less than a
+        // full turn away, any higher and it would wrap around to a bucket already passed.
+        void link(Hook& hook)
+        {
+            if (m_buckets.empty())
+            {
+                m_buckets.resize(numLevels * numBuckets(), nullptr);
+            }
+
+            const auto currentTicks{ m_time >> tickBits };
+            auto ticks{ std::max((hook.expiry >> tickBits) + 1, currentTicks + 1) };
+
+            unsigned level{ 0 };
+            for (; ((ticks >> (level * bucketBits)) - (currentTicks >> (level * bucketBits))) >= numBuckets(); ++level)
+            {
+                if (level == (numLevels - 1))
+                {
+                    // Further than the wheel reaches, it's rescheduled when the farthest bucket comes up
+                    ticks = ((currentTicks >> (level * bucketBits)) + numBuckets() - 1) << (level * bucketBits);
+                    break;
+                }
+            }
+
+            auto& bucket{ m_buckets[(level * numBuckets()) + ((ticks >> (level * bucketBits)) & (numBuckets() - 1))] };
+            hook.timerNext = bucket;
+            hook.timerLink = &bucket;
+
+            if (bucket != nullptr)
+            {
+                bucket->timerLink = &(hook.timerNext);
+            }
+
+            bucket = &hook;
+            ++m_numTimers;
+        }
+
+        void unlink(Hook& hook)
+        {
+            *(hook.timerLink) = hook.timerNext;
+
+            if (hook.timerNext != nullptr)
+            {
+                hook.timerNext->timerLink = hook.timerLink;
+            }
+
+            hook.timerLink = nullptr;
+            --m_numTimers;
+        }
+
+        // Entries that haven't expired yet move to a lower level
+        template<class FunctionT>
+        void expireBucket(Hook*& bucket, FunctionT& function)
+        {
+            auto hook{ bucket };
+            bucket = nullptr;
+
+            while (hook != nullptr)
+            {
+                const auto next{ hook->timerNext };
+                hook->timerLink = nullptr;
+                --m_numTimers;
+
+                if (hook->expiry <= m_time)
+                {
+                    function(*hook);
+                }
+                else
+                {
+                    link(*hook);
+                }
+
+                hook = next;
+            }
+        }
+    };
+}
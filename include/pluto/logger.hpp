@@ -9,22 +9,56 @@
 
 #include <map>
 #include <list>
+#include <deque>
 #include <mutex>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
 #include <atomic>
 #include <chrono>
+#include <limits>
 #include <string>
 #include <thread>
 #include <vector>
+#include <future>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
 #include <stdarg.h>
+#include <algorithm>
+#include <functional>
 #include <condition_variable>
 
 #ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
 #include <process.h>
 #else
+#include <fcntl.h>
+#include <limits.h>
 #include <unistd.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#endif
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define PLUTO_LOGGER_HAS_COROUTINES 1
+#endif
+#endif
+
+#ifndef PLUTO_LOGGER_HAS_COROUTINES
+#define PLUTO_LOGGER_HAS_COROUTINES 0
 #endif
 
 #include "filesystem.hpp"
@@ -38,6 +72,10 @@
 #define PLUTO_LOGGER_NO_SINGLETON 0   // Define as 1 or 0
 #endif
 
+#ifndef PLUTO_LOGGER_DEFAULT_NUM_WRITERS
+#define PLUTO_LOGGER_DEFAULT_NUM_WRITERS 1  // Number of writer threads, overridable in the constructor
+#endif
+
 // Configurable with macros or setters
 #ifndef PLUTO_LOGGER_DEFAULT_LEVEL
 #define PLUTO_LOGGER_DEFAULT_LEVEL pluto::Logger::Level::Verbose
@@ -71,6 +109,26 @@
 #define PLUTO_LOGGER_DEFAULT_BUFFER_FLUSH_SIZE 1
 #endif
 
+#ifndef PLUTO_LOGGER_DEFAULT_BUFFER_MAX_BATCH_SIZE
+#define PLUTO_LOGGER_DEFAULT_BUFFER_MAX_BATCH_SIZE 0  // 0 means a writer takes all of a file's logs at once
+#endif
+
+#ifndef PLUTO_LOGGER_DEFAULT_WRITER_WAKE_DELAY
+#define PLUTO_LOGGER_DEFAULT_WRITER_WAKE_DELAY 0  // Minimum time between a writer's rounds of batches (in microseconds)
+#endif
+
+#ifndef PLUTO_LOGGER_DEFAULT_WRITER_PRIORITY
+#define PLUTO_LOGGER_DEFAULT_WRITER_PRIORITY 0    // Nice value of the writer threads (Linux only)
+#endif
+
+#ifndef PLUTO_LOGGER_DEFAULT_BUFFER_RECYCLE_SIZE
+#define PLUTO_LOGGER_DEFAULT_BUFFER_RECYCLE_SIZE 1024 // Written logs kept per file for reuse
+#endif
+
+#ifndef PLUTO_LOGGER_DEFAULT_BUFFER_RECYCLE_CAPACITY
+#define PLUTO_LOGGER_DEFAULT_BUFFER_RECYCLE_CAPACITY 4096 // Largest string capacity a recycled log keeps (in bytes)
+#endif
+
 #ifndef PLUTO_LOGGER_DEFAULT_FILE_ROTATION_SIZE
 #define PLUTO_LOGGER_DEFAULT_FILE_ROTATION_SIZE 0 // 0 means no rotation (in bytes)
 #endif
@@ -79,6 +137,34 @@
 #define PLUTO_LOGGER_DEFAULT_FILE_ROTATION_LIMIT 1
 #endif
 
+#ifndef PLUTO_LOGGER_DEFAULT_FILE_ROTATION_PERIOD
+#define PLUTO_LOGGER_DEFAULT_FILE_ROTATION_PERIOD pluto::Logger::FileRotationPeriod::None
+#endif
+
+#ifndef PLUTO_LOGGER_DEFAULT_FILE_RETENTION_AGE
+#define PLUTO_LOGGER_DEFAULT_FILE_RETENTION_AGE 0 // 0 means rotated files are kept however old (in seconds)
+#endif
+
+#ifndef PLUTO_LOGGER_DEFAULT_FILE_RETENTION_SIZE
+#define PLUTO_LOGGER_DEFAULT_FILE_RETENTION_SIZE 0    // 0 means rotated files are kept however big in total (in bytes)
+#endif
+
+#ifndef PLUTO_LOGGER_DEFAULT_FILE_INDEX_INTERVAL
+#define PLUTO_LOGGER_DEFAULT_FILE_INDEX_INTERVAL 0    // 0 means no index, otherwise every Nth log is indexed in <log file>.idx
+#endif
+
+#ifndef PLUTO_LOGGER_DEFAULT_FILE_MAP_SIZE
+#define PLUTO_LOGGER_DEFAULT_FILE_MAP_SIZE 0  // 0 means files are written, not mapped (in bytes, ignored on Windows)
+#endif
+
+#ifndef PLUTO_LOGGER_DEFAULT_SHUTDOWN_TIMEOUT
+#define PLUTO_LOGGER_DEFAULT_SHUTDOWN_TIMEOUT 0 // 0 means wait for every log to be written (in milliseconds)
+#endif
+
+#ifndef PLUTO_LOGGER_DEFAULT_SHUTDOWN_SPILL_FILE
+#define PLUTO_LOGGER_DEFAULT_SHUTDOWN_SPILL_FILE "" // Empty means logs left at the shutdown timeout are discarded
+#endif
+
 #ifndef PLUTO_LOGGER_DEFAULT_TIMESTAMP_LENGTH
 #define PLUTO_LOGGER_DEFAULT_TIMESTAMP_LENGTH 26
 #endif
@@ -162,18 +248,22 @@
 #endif
 #endif
 
+// A static cache of the level for each place that logs, see Logger::CallSite
+#define PLUTO_LOGGER_CALL_SITE \
+    ([]() -> pluto::Logger::CallSite& { static pluto::Logger::CallSite callSite{}; return callSite; }())
+
 #if PLUTO_LOGGER_HIDE_SOURCE_INFO
 #define PLUTO_LOG_FORMAT(file, level, ...) \
-    pluto::Logger::getInstance().writef(file, level, "", 0, "", __VA_ARGS__)
+    pluto::Logger::getInstance().writef(PLUTO_LOGGER_CALL_SITE, file, level, "", 0, "", __VA_ARGS__)
 
 #define PLUTO_LOG_STREAM(file, level, message) \
-    pluto::Logger::getInstance().stream(file, level, "", 0, "") << message
+    pluto::Logger::getInstance().stream(PLUTO_LOGGER_CALL_SITE, file, level, "", 0, "") << message
 #else
 #define PLUTO_LOG_FORMAT(file, level, ...) \
-    pluto::Logger::getInstance().writef(file, level, __FILE__, __LINE__, __func__, __VA_ARGS__)
+    pluto::Logger::getInstance().writef(PLUTO_LOGGER_CALL_SITE, file, level, __FILE__, __LINE__, __func__, __VA_ARGS__)
 
 #define PLUTO_LOG_STREAM(file, level, message) \
-    pluto::Logger::getInstance().stream(file, level, __FILE__, __LINE__, __func__) << message
+    pluto::Logger::getInstance().stream(PLUTO_LOGGER_CALL_SITE, file, level, __FILE__, __LINE__, __func__) << message
 #endif
 
 #define PLUTO_LOG_FORMAT_NONE(file, ...)        PLUTO_LOG_FORMAT(file, pluto::Logger::Level::None, __VA_ARGS__)
@@ -237,605 +327,2684 @@ namespace pluto
             Function
         };
 
-    private:
-        struct Log
+        enum class Output : unsigned char
+        {
+            Stdout = 0,
+            Stderr
+        };
+
+        // Each period is logged to its own file, named like app.2026-10-17T13.log when hourly
+        enum class FileRotationPeriod : unsigned char
+        {
+            None = 0,
+            Hourly,
+            Daily
+        };
+
+        typedef std::function<void(const Level, const std::string&)> RouteCallback;
+        typedef std::function<void(const std::size_t numWritten, const std::size_t numRemaining)> ShutdownCallback;
+        typedef std::chrono::system_clock Clock;
+
+        // A log as sinks see it
+        struct LogRecord
         {
-            std::string     timestamp;
-            std::thread::id threadID;
+            Clock::time_point timestamp;  // Formatted by the writer thread
+            std::size_t     threadID;   // See Logger::threadID
             Level           level;
             const char*     sourceFilePath;
             int             sourceLine;
             const char*     sourceFunction;
             std::string     message;
+            std::string     rendered;   // Rendered once by the writer thread and shared by every sink
+        };
+
+        // Logs handed to a sink, which reads them through the pointers (e.g. log->rendered)
+        typedef std::vector<const LogRecord*> LogBatch;
+
+    private:
+        // Completion of a log written with writeAsync or awaitWrite. The writer thread completes
+        // every waiter in a batch once the batch is written, and a log that's dropped completes false.
+        class AsyncWrite
+        {
+            std::mutex                          m_mutex;
+            const bool                          m_sync;
+            bool                                m_isDone;
+            bool                                m_result;
+            std::unique_ptr<std::promise<bool>> m_promise;
+#if PLUTO_LOGGER_HAS_COROUTINES
+            std::coroutine_handle<>             m_handle;
+#endif
+
+        public:
+            AsyncWrite(const bool sync) :
+                m_mutex     {},
+                m_sync      { sync },
+                m_isDone    { false },
+                m_result    { false },
+                m_promise   {}
+#if PLUTO_LOGGER_HAS_COROUTINES
+                ,
+                m_handle    {}
+#endif
+            {}
+
+            bool sync() const { return m_sync; }
+
+            bool isDone()
+            {
+                const std::unique_lock<std::mutex> lock{ m_mutex };
+                return m_isDone;
+            }
+
+            bool result()
+            {
+                const std::unique_lock<std::mutex> lock{ m_mutex };
+                return m_result;
+            }
+
+            // Call at most once, before the log is added
+            std::future<bool> getFuture()
+            {
+                m_promise.reset(new std::promise<bool>{});
+                return m_promise->get_future();
+            }
+
+#if PLUTO_LOGGER_HAS_COROUTINES
+            // Returns false if already done, in which case the coroutine carries on without suspending
+            bool suspend(const std::coroutine_handle<> handle)
+            {
+                const std::unique_lock<std::mutex> lock{ m_mutex };
+
+                if (m_isDone)
+                {
+                    return false;
+                }
+
+                m_handle = handle;
+                return true;
+            }
+#endif
+
+            // Only the first result counts
+            void complete(const bool result)
+            {
+                std::unique_lock<std::mutex> lock{ m_mutex };
+
+                if (m_isDone)
+                {
+                    return;
+                }
+
+                m_isDone = true;
+                m_result = result;
+
+#if PLUTO_LOGGER_HAS_COROUTINES
+                const auto handle{ m_handle };
+                m_handle = nullptr;
+#endif
+                lock.unlock();
+
+                if (m_promise)
+                {
+                    m_promise->set_value(result);
+                }
+
+#if PLUTO_LOGGER_HAS_COROUTINES
+                if (handle)
+                {
+                    handle.resume();
+                }
+#endif
+            }
+        };
+
+        // Hands a formatted message to a log by swapping strings, the caller gets back the
+        // log's recycled string to format the next message into.
+        struct SwapMessage
+        {
+            std::string& message;
+        };
+
+        // Written logs are recycled into new ones, reusing the list node and string
+        // capacity, so a steady stream of logs doesn't allocate or free on either thread.
+        struct Log : LogRecord
+        {
+            std::shared_ptr<AsyncWrite> asyncWrite; // Set for logs from writeAsync, reset before the log is recycled
 
             Log(
-                const std::string&      timestamp,
-                const std::thread::id&  threadID,
+                const Clock::time_point timestamp,
+                const std::size_t       threadID,
                 const Level             level,
                 const char*             sourceFilePath,
                 const int               sourceLine,
                 const char*             sourceFunction,
                 const std::string&      message) :
-                timestamp       { timestamp },
-                threadID        { threadID },
-                level           { level },
-                sourceFilePath  { sourceFilePath },
-                sourceLine      { sourceLine },
-                sourceFunction  { sourceFunction },
-                message         { message } {}
-
-            ~Log() {}
-        };
+                LogRecord   { timestamp, threadID, level, sourceFilePath, sourceLine, sourceFunction, message, {} },
+                asyncWrite  {} {}
 
-        class Stream
-        {
-            Logger* const       m_logger;
-            const std::string   m_logFileName;
-            const Level         m_logLevel;
-            const char* const   m_sourceFilePath;
-            const int           m_sourceLine;
-            const char* const   m_sourceFunction;
-            std::stringstream   m_stream;
+            Log(
+                const Clock::time_point timestamp,
+                const std::size_t       threadID,
+                const Level             level,
+                const char*             sourceFilePath,
+                const int               sourceLine,
+                const char*             sourceFunction,
+                std::string&&           message) :
+                LogRecord   { timestamp, threadID, level, sourceFilePath, sourceLine, sourceFunction, std::move(message), {} },
+                asyncWrite  {} {}
 
-        public:
-            Stream(
-                Logger* const       logger,
-                const std::string   logFileName,
-                const Level         logLevel,
-                const char* const   sourceFilePath,
-                const int           sourceLine,
-                const char* const   sourceFunction) :
-                m_logger        { logger },
-                m_logFileName   { logFileName },
-                m_logLevel      { logLevel },
-                m_sourceFilePath{ sourceFilePath },
-                m_sourceLine    { sourceLine },
-                m_sourceFunction{ sourceFunction },
-                m_stream        {} {}
+            Log(
+                const Clock::time_point timestamp,
+                const std::size_t       threadID,
+                const Level             level,
+                const char*             sourceFilePath,
+                const int               sourceLine,
+                const char*             sourceFunction,
+                const SwapMessage       swapMessage) :
+                LogRecord   { timestamp, threadID, level, sourceFilePath, sourceLine, sourceFunction, {}, {} },
+                asyncWrite  {}
+            {
+                message.swap(swapMessage.message);
+            }
 
-            ~Stream()
+            // A log dropped before it was written, e.g. at the shutdown timeout, fails its waiter
+            ~Log()
             {
-                try
+                if (asyncWrite)
                 {
-                    if (m_logger && m_logger->shouldLog(m_logLevel))
-                    {
-                        m_logger->addLogToBuffer(
-                            m_logFileName,
-                            m_logLevel,
-                            m_sourceFilePath,
-                            m_sourceLine,
-                            m_sourceFunction,
-                            m_stream.str());
-                    }
+                    asyncWrite->complete(false);
                 }
-                catch (...) {}
             }
 
-            Stream& operator<<(const bool b)
+            // Copies into the recycled capacity. A template so C strings from writef are
+            // assigned directly rather than taking the overload below through a temporary.
+            template<class MessageT>
+            void reuse(
+                const Clock::time_point newTimestamp,
+                const std::size_t       newThreadID,
+                const Level             newLevel,
+                const char*             newSourceFilePath,
+                const int               newSourceLine,
+                const char*             newSourceFunction,
+                const MessageT&         newMessage)
             {
-                m_stream << std::boolalpha << b;
-                return *this;
+                timestamp       = newTimestamp;
+                threadID        = newThreadID;
+                level           = newLevel;
+                sourceFilePath  = newSourceFilePath;
+                sourceLine      = newSourceLine;
+                sourceFunction  = newSourceFunction;
+                message.assign(newMessage);
             }
 
-            template<class T>
-            Stream& operator<<(const T& value)
+            // Takes the caller's string rather than copying into the recycled capacity
+            void reuse(
+                const Clock::time_point newTimestamp,
+                const std::size_t       newThreadID,
+                const Level             newLevel,
+                const char*             newSourceFilePath,
+                const int               newSourceLine,
+                const char*             newSourceFunction,
+                std::string&&           newMessage)
             {
-                m_stream << value;
-                return *this;
+                timestamp       = newTimestamp;
+                threadID        = newThreadID;
+                level           = newLevel;
+                sourceFilePath  = newSourceFilePath;
+                sourceLine      = newSourceLine;
+                sourceFunction  = newSourceFunction;
+                message         = std::move(newMessage);
+            }
+
+            void reuse(
+                const Clock::time_point newTimestamp,
+                const std::size_t       newThreadID,
+                const Level             newLevel,
+                const char*             newSourceFilePath,
+                const int               newSourceLine,
+                const char*             newSourceFunction,
+                const SwapMessage       newMessage)
+            {
+                timestamp       = newTimestamp;
+                threadID        = newThreadID;
+                level           = newLevel;
+                sourceFilePath  = newSourceFilePath;
+                sourceLine      = newSourceLine;
+                sourceFunction  = newSourceFunction;
+                message.swap(newMessage.message);
             }
         };
 
-        typedef std::list<Log> LogBuffer;
+    public:
+#if PLUTO_LOGGER_HAS_COROUTINES
+        // Returned by awaitWrite. co_await gives true once the log is written.
+        class WriteAwaiter
+        {
+            std::shared_ptr<AsyncWrite> m_asyncWrite;
 
-        struct LogFile
+        public:
+            WriteAwaiter(const std::shared_ptr<AsyncWrite>& asyncWrite) :
+                m_asyncWrite{ asyncWrite } {}
+
+            bool await_ready() const                                { return m_asyncWrite->isDone(); }
+            bool await_suspend(const std::coroutine_handle<> handle) { return m_asyncWrite->suspend(handle); }
+            bool await_resume() const                               { return m_asyncWrite->result(); }
+        };
+#endif
+
+        // Caches the level resolved for one place that logs, so checking it is a relaxed load compared
+        // against the levels epoch and the log file. Changing any level bumps the epoch, which makes
+        // every call site resolve its level again the next time it logs. The level can depend on the
+        // log file name given at run time, so the cache keeps the file's interned ID and logging to
+        // another file resolves it again too.
+        class CallSite
         {
-            LogBuffer                   buffer;
-            pluto::FileSystem::path     filePath;
-            bool                        dirsCreated;
+            friend class Logger;
+
+            std::atomic<std::uint64_t> m_cache; // Valid bit, 39 bits of epoch, 16 bits of file ID, level
+
+            static constexpr std::uint64_t key(const std::uint64_t epoch, const std::size_t fileID)
+            {
+                return ((std::uint64_t{ 1 } << 63) | ((epoch & 0x7FFFFFFFFF) << 24) |
+                    ((static_cast<std::uint64_t>(fileID) & 0xFFFF) << 8));
+            }
 
-            LogFile() :
-                buffer      {},
-                filePath    {},
-                dirsCreated { false } {}
+        public:
+            constexpr CallSite() :
+                m_cache{ 0 } {}
         };
 
-        mutable std::mutex              m_loggingMutex          {};
-        std::thread                     m_loggingThread         {};
-        std::condition_variable         m_loggingThreadCondition{};
-        std::map<std::string, LogFile>  m_logFiles              {};
+        // Destination for batches of rendered logs. The same sink can be reached from
+        // several writer threads through routes, so the logger serializes calls to write.
+        class Sink
+        {
+            friend class Logger;
 
-#ifdef _WIN32
-        const int m_processID{ _getpid() };
-#else
-        const int m_processID{ getpid() };
-#endif
+            std::mutex  m_mutex         {};
+            bool        m_shouldSync    { false };
 
-        std::atomic_bool            m_isLogging             { true };
-        std::atomic<Level>          m_level                 { PLUTO_LOGGER_DEFAULT_LEVEL };
-        std::atomic<LevelFormat>    m_levelFormat           { PLUTO_LOGGER_DEFAULT_LEVEL_FORMAT };
-        std::atomic_bool            m_createDirs            { PLUTO_LOGGER_DEFAULT_CREATE_DIRS };
-        std::atomic_bool            m_writeHeader           { PLUTO_LOGGER_DEFAULT_WRITE_HEADER };
-        std::atomic_bool            m_writeHeaderUnderline  { PLUTO_LOGGER_DEFAULT_WRITE_HEADER_UNDERLINE };
-        std::atomic_char            m_headerUnderlineFill   { PLUTO_LOGGER_DEFAULT_HEADER_UNDERLINE_FILL };
-        std::atomic_size_t          m_bufferMaxSize         { PLUTO_LOGGER_DEFAULT_BUFFER_MAX_SIZE };
-        std::atomic_size_t          m_bufferFlushSize       { PLUTO_LOGGER_DEFAULT_BUFFER_FLUSH_SIZE };
-        std::atomic_size_t          m_fileRotationSize      { PLUTO_LOGGER_DEFAULT_FILE_ROTATION_SIZE };
-        std::atomic_size_t          m_fileRotationLimit     { PLUTO_LOGGER_DEFAULT_FILE_ROTATION_LIMIT };
-        std::atomic_size_t          m_numDiscardedLogs      { 0 };
-        std::atomic_size_t          m_timestampLength       { PLUTO_LOGGER_DEFAULT_TIMESTAMP_LENGTH };
-        std::atomic_size_t          m_processIDLength       { PLUTO_LOGGER_DEFAULT_PROCESS_ID_LENGTH };
-        std::atomic_size_t          m_threadIDLength        { PLUTO_LOGGER_DEFAULT_THREAD_ID_LENGTH };
-        std::atomic_size_t          m_fileNameLength        { PLUTO_LOGGER_DEFAULT_FILE_NAME_LENGTH };
-        std::atomic_size_t          m_lineLength            { PLUTO_LOGGER_DEFAULT_LINE_LENGTH };
-        std::atomic_size_t          m_functionLength        { PLUTO_LOGGER_DEFAULT_FUNCTION_LENGTH };
+        public:
+            virtual ~Sink() {}
 
-        mutable std::mutex          m_configMutex               {};
-        std::string                 m_separator                 { PLUTO_LOGGER_DEFAULT_SEPARATOR };
-        std::string                 m_headerUnderlineSeparator  { PLUTO_LOGGER_DEFAULT_HEADER_UNDERLINE_SEPARATOR };
-        std::string                 m_timestampFormat           { PLUTO_LOGGER_DEFAULT_TIMESTAMP_FORMAT };
-        std::string                 m_timestampHeader           { PLUTO_LOGGER_DEFAULT_TIMESTAMP_HEADER };
-        std::string                 m_processIDHeader           { PLUTO_LOGGER_DEFAULT_PROCESS_ID_HEADER };
-        std::string                 m_threadIDHeader            { PLUTO_LOGGER_DEFAULT_THREAD_ID_HEADER };
-        std::string                 m_fileNameHeader            { PLUTO_LOGGER_DEFAULT_FILE_NAME_HEADER };
-        std::string                 m_lineHeader                { PLUTO_LOGGER_DEFAULT_LINE_HEADER };
-        std::string                 m_functionHeader            { PLUTO_LOGGER_DEFAULT_FUNCTION_HEADER };
-        std::string                 m_messageHeader             { PLUTO_LOGGER_DEFAULT_MESSAGE_HEADER };
-        std::vector<MetaDataColumn> m_metaDataColumns           { PLUTO_LOGGER_DEFAULT_META_DATA_COLUMNS };
+            // Return false if the logs could not be written, they are retried after a backoff that
+            // doubles from 1ms up to a second
+            virtual bool write(const LogBatch& logs) = 0;
 
-#if PLUTO_LOGGER_NO_SINGLETON
-    public:
-#endif
-        Logger()
+        protected:
+            // True while writing a batch with a log from writeAsync that asked for sync,
+            // the logs should then be durable (e.g. fsynced) before write returns.
+            bool shouldSync() const { return m_shouldSync; }
+        };
+
+        // Entry in a log file's sidecar index, see fileIndexInterval. Entries are appended in file order
+        // and their timestamps never go back, so the index of a segment can be binary searched for the
+        // logs in a time range. A log written after one with a later timestamp is indexed at that time.
+        struct IndexEntry
         {
-            m_loggingThread = std::thread(&Logger::startLogging, this);
-        }
+            std::int64_t    timestamp;  // Nanoseconds since the epoch
+            std::uint64_t   offset;     // Of the log in the log file
+        };
 
-        ~Logger()
+    private:
+        // Collects the index entries for a batch and appends them once the batch is written.
+        // The index is best effort, without it a query scans the whole file.
+        class FileIndex
         {
-            m_isLogging.store(false);
-            m_loggingThreadCondition.notify_all();
+            pluto::FileSystem::path     m_path;
+            std::size_t                 m_numLogs;
+            std::int64_t                m_timestamp;    // Latest of the file's logs so far
+            std::vector<IndexEntry>     m_entries;
 
-            if (m_loggingThread.joinable())
+        public:
+            FileIndex() :
+                m_path      {},
+                m_numLogs   { 0 },
+                m_timestamp { std::numeric_limits<std::int64_t>::min() },
+                m_entries   {} {}
+
+            // Start indexing another log file
+            void open(const pluto::FileSystem::path& filePath)
             {
-                m_loggingThread.join();
+                flush();
+                m_path = getIndexFilePath(filePath);
+                m_numLogs = 0;
+                m_timestamp = std::numeric_limits<std::int64_t>::min();
             }
 
-            // Write all buffers to their files
-            for (auto& logFilePair : m_logFiles)
+            // Producers timestamp logs before queueing them, so logs can arrive a little out of order.
+            // Every log moves the latest timestamp on, not just the indexed ones.
+            void add(const std::size_t interval, const Clock::time_point timestamp, const std::size_t offset)
             {
-                auto& fileName      { logFilePair.first };
-                auto& buffer        { logFilePair.second.buffer };
-                auto& filePath      { logFilePair.second.filePath };
-                auto& dirsCreated   { logFilePair.second.dirsCreated };
-
-                if (!buffer.empty())
+                if (interval != 0)
                 {
-                    writeBufferToFile(buffer.begin(), --(buffer.end()), fileName, filePath, dirsCreated);
+                    m_timestamp = std::max(m_timestamp, static_cast<std::int64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count()));
+
+                    if ((m_numLogs++ % interval) == 0)
+                    {
+                        m_entries.push_back({ m_timestamp, static_cast<std::uint64_t>(offset) });
+                    }
                 }
             }
-        }
 
-    public:
-        Logger(const Logger&) = delete;
+            void flush()
+            {
+                if (!m_entries.empty())
+                {
+                    std::ofstream indexStream{ m_path, (std::ios_base::binary | std::ios_base::app) };
+                    indexStream.write(reinterpret_cast<const char*>(m_entries.data()),
+                        static_cast<std::streamsize>(m_entries.size() * sizeof(IndexEntry)));
 
-        void operator=(const Logger&) = delete;
+                    m_entries.clear();
+                }
+            }
+        };
 
-        static Logger& getInstance()
+        // Lets writer threads and file sinks stop using the logger once it's destroyed, which a writer
+        // detached at the shutdown timeout can outlive. They only call into the logger unlocked through
+        // a Use, and the destructor waits out the uses in progress before ending the lifetime.
+        class Lifetime
         {
-            static Logger instance{};
-            return instance;
-        }
+            std::mutex              m_mutex;
+            std::condition_variable m_condition;
+            const Logger*           m_logger;
+            std::size_t             m_numUses;
 
-        static inline std::string getLocalTimestamp(const char* const format)
-        {
-            const auto nowTime{ std::chrono::system_clock::now() };
-            const auto nowPosixTime{ std::chrono::system_clock::to_time_t(nowTime) };
+        public:
+            Lifetime(const Logger& logger) :
+                m_mutex     {},
+                m_condition {},
+                m_logger    { &logger },
+                m_numUses   { 0 } {}
+
+            // Uses are short and never span a sink's write, so this doesn't wait for long
+            void end()
+            {
+                std::unique_lock<std::mutex> lock{ m_mutex };
+                m_logger = nullptr;
+                m_condition.wait(lock, [this]() { return (m_numUses == 0); });
+            }
 
-            std::tm nowLocalTime{};
-#ifdef _WIN32
-            if (localtime_s(&nowLocalTime, &nowPosixTime) == 0)
-#else
-            if (localtime_r(&nowPosixTime, &nowLocalTime) != nullptr)
-#endif
+            bool hasEnded()
             {
-                std::string formatCopy{ format };
+                const std::unique_lock<std::mutex> lock{ m_mutex };
+                return (m_logger == nullptr);
+            }
 
-                for (std::size_t i{ 0 }; (i + 3) < formatCopy.size(); ++i)
-                {
-                    if (formatCopy[i] == '%' && formatCopy[i + 1] == '.' && formatCopy[i + 3] == 'S')
-                    {
-                        const auto precision{ static_cast<std::size_t>(formatCopy[i + 2]) - '0' };
+            class Use
+            {
+                Lifetime&           m_lifetime;
+                const Logger* const m_logger;
 
-                        if (0 < precision && precision < 10)
-                        {
-                            const auto nowNanoseconds{ std::chrono::duration_cast<std::chrono::nanoseconds>(
-                                nowTime.time_since_epoch()).count() % 1'000'000'000 };
+            public:
+                Use(Lifetime& lifetime) :
+                    m_lifetime  { lifetime },
+                    m_logger    { lifetime.enter() } {}
 
-                            formatCopy.replace(i, 4, std::to_string(nowNanoseconds), 0, precision);
-                        }
+                ~Use()
+                {
+                    if (m_logger != nullptr)
+                    {
+                        m_lifetime.leave();
                     }
                 }
 
-                std::ostringstream ss{};
-                ss << std::put_time(&nowLocalTime, formatCopy.c_str());
+                Use(const Use&) = delete;
+
+                void operator=(const Use&) = delete;
+
+                explicit operator bool() const { return (m_logger != nullptr); }
+
+                // For file sinks, which give up on the batch if the logger is gone
+                const Logger& logger() const
+                {
+                    if (m_logger == nullptr)
+                    {
+                        throw pluto::FileSystem::filesystem_error{ "Logger was destroyed",
+                            std::make_error_code(std::errc::operation_canceled) };
+                    }
+
+                    return *m_logger;
+                }
+            };
+
+        private:
+            const Logger* enter()
+            {
+                const std::unique_lock<std::mutex> lock{ m_mutex };
+
+                if (m_logger != nullptr)
+                {
+                    ++m_numUses;
+                }
+
+                return m_logger;
+            }
+
+            void leave()
+            {
+                const std::unique_lock<std::mutex> lock{ m_mutex };
+
+                if (--m_numUses == 0)
+                {
+                    m_condition.notify_all();
+                }
+            }
+        };
+
+    public:
+        // Default sink for log files. On POSIX the file stays open between batches
+        // and each batch is gathered into iovecs pointing at the rendered logs for writev.
+        class FileSink : public Sink
+        {
+            const std::shared_ptr<Lifetime> m_lifetime;
+            const std::string           m_fileName;
+            pluto::FileSystem::path     m_basePath;
+            pluto::FileSystem::path     m_filePath;         // Differs from the base path when rotating by time
+            FileRotationPeriod          m_rotationPeriod;
+            Clock::time_point           m_nextRotationTime;
+            FileIndex                   m_index;
+            bool                        m_dirsCreated;
+            std::string                 m_header;
+#ifndef _WIN32
+            int                         m_fd;
+            std::vector<iovec>          m_iovecs;
+#endif
+
+        public:
+            FileSink(const std::shared_ptr<Lifetime>& lifetime, const std::string& fileName) :
+                m_lifetime          { lifetime },
+                m_fileName          { fileName },
+                m_basePath          {},
+                m_filePath          {},
+                m_rotationPeriod    { FileRotationPeriod::None },
+                m_nextRotationTime  { Clock::time_point::min() },
+                m_index             {},
+                m_dirsCreated       { false },
+                m_header            {}
+#ifndef _WIN32
+                ,
+                m_fd                { -1 },
+                m_iovecs            {}
+#endif
+            {}
+
+            ~FileSink()
+            {
+#ifndef _WIN32
+                closeFile();
+#endif
+            }
+
+            bool write(const LogBatch& logs) override
+            {
+                auto result{ true };
+
+                try
+                {
+                    // Get file path if empty
+                    if (m_basePath.empty())
+                    {
+                        m_basePath = pluto::FileSystem::absolute(m_fileName);
+                    }
+
+                    writeLogs(logs);
+                }
+                catch (const pluto::FileSystem::filesystem_error&)
+                {
+                    result = false;
+                }
+
+                return result;
+            }
+
+        private:
+#ifdef _WIN32
+            void writeLogs(const LogBatch& logs)
+            {
+                auto writeHeader{ false };
+                std::size_t fileRotationSize{ 0 };
+                std::size_t fileIndexInterval{ 0 };
+
+                std::size_t fileSize{ 0 };
+                std::ofstream fileStream{};
+
+                {
+                    const Lifetime::Use use{ *m_lifetime };
+                    const auto& logger{ use.logger() };
+
+                    writeHeader = logger.writeHeader();
+                    fileRotationSize = logger.fileRotationSize();
+                    fileIndexInterval = logger.fileIndexInterval();
+
+                    // Create path to file if needed
+                    if (logger.createDirs() && !m_dirsCreated)
+                    {
+                        pluto::FileSystem::create_directories(m_basePath.parent_path());
+                        m_dirsCreated = true;
+                    }
+
+                    // Pick the file again if the rotation period changed
+                    const auto fileRotationPeriod{ logger.fileRotationPeriod() };
+                    if (fileRotationPeriod != m_rotationPeriod)
+                    {
+                        m_rotationPeriod = fileRotationPeriod;
+                        m_nextRotationTime = Clock::time_point::min();
+                    }
+
+                    if (!logs.empty() && m_nextRotationTime <= logs.front()->timestamp)
+                    {
+                        m_filePath = logger.startRotationPeriod(
+                            m_basePath, m_rotationPeriod, logs.front()->timestamp, m_nextRotationTime);
+                        m_index.open(m_filePath);
+                    }
+                }
+
+                openFileStream(fileStream, m_filePath);
+
+                for (const auto log : logs)
+                {
+                    // Start the next period's file if needed, a comparison against its precomputed start
+                    if (m_nextRotationTime <= log->timestamp)
+                    {
+                        closeFileStream(fileStream);
+
+                        {
+                            const Lifetime::Use use{ *m_lifetime };
+                            m_filePath = use.logger().startRotationPeriod(
+                                m_basePath, m_rotationPeriod, log->timestamp, m_nextRotationTime);
+                        }
+
+                        m_index.open(m_filePath);
+                        openFileStream(fileStream, m_filePath);
+                    }
+
+                    fileSize = static_cast<std::size_t>(fileStream.tellp());
+
+                    // Rotate file if needed
+                    if (fileRotationSize != 0 && fileRotationSize <= fileSize)
+                    {
+                        closeFileStream(fileStream);
+                        m_index.flush();
+
+                        {
+                            const Lifetime::Use use{ *m_lifetime };
+                            use.logger().rotateFile(m_filePath);
+                            use.logger().removeExpiredFiles(m_basePath, m_filePath);
+                        }
+
+                        m_index.open(m_filePath);
+                        openFileStream(fileStream, m_filePath);
+                        fileSize = static_cast<std::size_t>(fileStream.tellp());
+                    }
+
+                    // Write header if needed
+                    if (writeHeader && fileSize == 0)
+                    {
+                        const Lifetime::Use use{ *m_lifetime };
+                        use.logger().writeHeaderToStream(fileStream);
+                        fileSize = static_cast<std::size_t>(fileStream.tellp());
+                    }
+
+                    m_index.add(fileIndexInterval, log->timestamp, fileSize);
+                    fileStream << log->rendered;
+                }
+
+                closeFileStream(fileStream);
+                m_index.flush();
+            }
+
+            void closeFileStream(std::ofstream& fileStream)
+            {
+                fileStream.close();
+
+                // The stream doesn't expose its handle, commit the file through another one
+                if (shouldSync())
+                {
+                    const auto fd{ ::_wopen(m_filePath.c_str(), _O_WRONLY) };
+                    const auto result{ (fd != -1) && (::_commit(fd) == 0) };
+
+                    if (fd != -1)
+                    {
+                        ::_close(fd);
+                    }
+
+                    if (!result)
+                    {
+                        throw pluto::FileSystem::filesystem_error{ "Logger failed to sync file",
+                            std::make_error_code(std::errc::io_error) };
+                    }
+                }
+            }
+#else
+            static void throwIOError()
+            {
+                throw pluto::FileSystem::filesystem_error{ "Logger failed to write file",
+                    std::error_code{ errno, std::generic_category() } };
+            }
+
+            void closeFile()
+            {
+                if (m_fd != -1)
+                {
+                    ::close(m_fd);
+                    m_fd = -1;
+                }
+            }
+
+            void syncFile()
+            {
+                if (shouldSync() && m_fd != -1 && ::fsync(m_fd) != 0)
+                {
+                    throwIOError();
+                }
+            }
+
+            // Returns the size of the file, reopening it if it was closed or removed
+            std::size_t openFile()
+            {
+                struct stat fileStat{};
+
+                if (m_fd != -1)
+                {
+                    if (::fstat(m_fd, &fileStat) == 0 && fileStat.st_nlink != 0)
+                    {
+                        return static_cast<std::size_t>(fileStat.st_size);
+                    }
+
+                    closeFile();
+                }
+
+                m_fd = ::open(m_filePath.c_str(), (O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC), 0644);
+                if (m_fd == -1 || ::fstat(m_fd, &fileStat) != 0)
+                {
+                    throw pluto::FileSystem::filesystem_error{ "Logger failed to open file",
+                        std::make_error_code(std::errc::io_error) };
+                }
+
+                return static_cast<std::size_t>(fileStat.st_size);
+            }
+
+            void flushIOVecs()
+            {
+                auto it{ m_iovecs.begin() };
+
+                while (it != m_iovecs.end())
+                {
+                    const auto count{ std::min<std::ptrdiff_t>(std::distance(it, m_iovecs.end()), IOV_MAX) };
+                    auto written{ ::writev(m_fd, &(*it), static_cast<int>(count)) };
+
+                    if (written < 0)
+                    {
+                        if (errno == EINTR)
+                        {
+                            continue;
+                        }
+
+                        m_iovecs.clear();
+                        throwIOError();
+                    }
+
+                    // Skip what was written, a partial write resumes mid iovec
+                    for (; it != m_iovecs.end() && static_cast<std::size_t>(written) >= it->iov_len; ++it)
+                    {
+                        written -= static_cast<ssize_t>(it->iov_len);
+                    }
+
+                    if (it != m_iovecs.end())
+                    {
+                        it->iov_base = static_cast<char*>(it->iov_base) + written;
+                        it->iov_len -= static_cast<std::size_t>(written);
+                    }
+                }
+
+                m_iovecs.clear();
+            }
+
+            void writeLogs(const LogBatch& logs)
+            {
+                auto writeHeader{ false };
+                std::size_t fileRotationSize{ 0 };
+                std::size_t fileIndexInterval{ 0 };
+
+                {
+                    const Lifetime::Use use{ *m_lifetime };
+                    const auto& logger{ use.logger() };
+
+                    writeHeader = logger.writeHeader();
+                    fileRotationSize = logger.fileRotationSize();
+                    fileIndexInterval = logger.fileIndexInterval();
+
+                    // Create path to file if needed
+                    if (logger.createDirs() && !m_dirsCreated)
+                    {
+                        pluto::FileSystem::create_directories(m_basePath.parent_path());
+                        m_dirsCreated = true;
+                    }
+
+                    // Pick the file again if the rotation period changed
+                    const auto fileRotationPeriod{ logger.fileRotationPeriod() };
+                    if (fileRotationPeriod != m_rotationPeriod)
+                    {
+                        m_rotationPeriod = fileRotationPeriod;
+                        m_nextRotationTime = Clock::time_point::min();
+                    }
+
+                    if (!logs.empty() && m_nextRotationTime <= logs.front()->timestamp)
+                    {
+                        closeFile();
+                        m_filePath = logger.startRotationPeriod(
+                            m_basePath, m_rotationPeriod, logs.front()->timestamp, m_nextRotationTime);
+                        m_index.open(m_filePath);
+                    }
+                }
+
+                auto fileSize{ openFile() };
+                m_header.clear();
+
+                for (const auto log : logs)
+                {
+                    // Start the next period's file if needed, a comparison against its precomputed start
+                    if (m_nextRotationTime <= log->timestamp)
+                    {
+                        flushIOVecs();
+                        syncFile();
+                        closeFile();
+
+                        {
+                            const Lifetime::Use use{ *m_lifetime };
+                            m_filePath = use.logger().startRotationPeriod(
+                                m_basePath, m_rotationPeriod, log->timestamp, m_nextRotationTime);
+                        }
+
+                        m_index.open(m_filePath);
+                        fileSize = openFile();
+                    }
+
+                    // Rotate file if needed
+                    if (fileRotationSize != 0 && fileRotationSize <= fileSize)
+                    {
+                        flushIOVecs();
+                        syncFile();
+                        closeFile();
+                        m_index.flush();
+
+                        {
+                            const Lifetime::Use use{ *m_lifetime };
+                            use.logger().rotateFile(m_filePath);
+                            use.logger().removeExpiredFiles(m_basePath, m_filePath);
+                        }
+
+                        m_index.open(m_filePath);
+                        fileSize = openFile();
+                    }
+
+                    // Write header if needed, rendered at most once per batch
+                    if (writeHeader && fileSize == 0)
+                    {
+                        if (m_header.empty())
+                        {
+                            const Lifetime::Use use{ *m_lifetime };
+                            std::ostringstream stream{};
+                            use.logger().writeHeaderToStream(stream);
+                            m_header = stream.str();
+                        }
+
+                        m_iovecs.push_back({ const_cast<char*>(m_header.data()), m_header.size() });
+                        fileSize += m_header.size();
+                    }
+
+                    m_index.add(fileIndexInterval, log->timestamp, fileSize);
+                    m_iovecs.push_back({ const_cast<char*>(log->rendered.data()), log->rendered.size() });
+                    fileSize += log->rendered.size();
+                }
+
+                // Index entries are written after the logs they point to
+                flushIOVecs();
+                syncFile();
+                m_index.flush();
+            }
+#endif
+        };
+
+#ifndef _WIN32
+        // Sink for log files when fileMapSize is set. Each segment is preallocated and mapped,
+        // the writer copies logs straight into the mapping so steady state logging makes no syscalls.
+        // Logs are in the page cache as soon as they're copied, so they survive the process crashing.
+        // The file is rotated when its segment fills and truncated to what was logged when closed.
+        class MappedFileSink : public Sink
+        {
+            const std::shared_ptr<Lifetime> m_lifetime;
+            const std::string           m_fileName;
+            pluto::FileSystem::path     m_basePath;
+            pluto::FileSystem::path     m_filePath;         // Differs from the base path when rotating by time
+            FileRotationPeriod          m_rotationPeriod;
+            Clock::time_point           m_nextRotationTime;
+            FileIndex                   m_index;
+            bool                        m_dirsCreated;
+            std::string                 m_header;
+            int                         m_fd;
+            char*                       m_map;
+            std::size_t                 m_mapSize;
+            std::size_t                 m_fileSize;
+            std::size_t                 m_segmentSize;      // Read from the logger once per batch
+
+        public:
+            MappedFileSink(const std::shared_ptr<Lifetime>& lifetime, const std::string& fileName) :
+                m_lifetime          { lifetime },
+                m_fileName          { fileName },
+                m_basePath          {},
+                m_filePath          {},
+                m_rotationPeriod    { FileRotationPeriod::None },
+                m_nextRotationTime  { Clock::time_point::min() },
+                m_index             {},
+                m_dirsCreated       { false },
+                m_header            {},
+                m_fd                { -1 },
+                m_map               { nullptr },
+                m_mapSize           { 0 },
+                m_fileSize          { 0 },
+                m_segmentSize       { 0 } {}
+
+            ~MappedFileSink()
+            {
+                closeFile();
+            }
+
+            bool write(const LogBatch& logs) override
+            {
+                auto result{ true };
+
+                try
+                {
+                    // Get file path if empty
+                    if (m_basePath.empty())
+                    {
+                        m_basePath = pluto::FileSystem::absolute(m_fileName);
+                    }
+
+                    auto writeHeader{ false };
+                    std::size_t fileRotationSize{ 0 };
+                    std::size_t fileIndexInterval{ 0 };
+
+                    {
+                        const Lifetime::Use use{ *m_lifetime };
+                        const auto& logger{ use.logger() };
+
+                        writeHeader = logger.writeHeader();
+                        fileRotationSize = logger.fileRotationSize();
+                        fileIndexInterval = logger.fileIndexInterval();
+                        m_segmentSize = logger.fileMapSize();
+
+                        // Create path to file if needed
+                        if (logger.createDirs() && !m_dirsCreated)
+                        {
+                            pluto::FileSystem::create_directories(m_basePath.parent_path());
+                            m_dirsCreated = true;
+                        }
+
+                        // Pick the file again if the rotation period changed
+                        const auto fileRotationPeriod{ logger.fileRotationPeriod() };
+                        if (fileRotationPeriod != m_rotationPeriod)
+                        {
+                            m_rotationPeriod = fileRotationPeriod;
+                            m_nextRotationTime = Clock::time_point::min();
+                        }
+
+                        if (!logs.empty() && m_nextRotationTime <= logs.front()->timestamp)
+                        {
+                            closeFile();
+                            m_filePath = logger.startRotationPeriod(
+                                m_basePath, m_rotationPeriod, logs.front()->timestamp, m_nextRotationTime);
+                            m_index.open(m_filePath);
+                        }
+                    }
+
+                    if (m_map == nullptr)
+                    {
+                        openFile();
+                    }
+
+                    m_header.clear();
+
+                    for (const auto log : logs)
+                    {
+                        // Start the next period's file if needed, a comparison against its precomputed start
+                        if (m_nextRotationTime <= log->timestamp)
+                        {
+                            syncFile();
+                            closeFile();
+
+                            {
+                                const Lifetime::Use use{ *m_lifetime };
+                                m_filePath = use.logger().startRotationPeriod(
+                                    m_basePath, m_rotationPeriod, log->timestamp, m_nextRotationTime);
+                            }
+
+                            m_index.open(m_filePath);
+                            openFile();
+                        }
+
+                        // Rotate file if its segment is full or it reached the rotation size
+                        if (m_fileSize != 0 && ((m_mapSize < (m_fileSize + log->rendered.size())) ||
+                            (fileRotationSize != 0 && fileRotationSize <= m_fileSize)))
+                        {
+                            syncFile();
+                            closeFile();
+                            m_index.flush();
+
+                            {
+                                const Lifetime::Use use{ *m_lifetime };
+                                use.logger().rotateFile(m_filePath);
+                                use.logger().removeExpiredFiles(m_basePath, m_filePath);
+                            }
+
+                            m_index.open(m_filePath);
+                            openFile();
+                        }
+
+                        // Write header if needed, rendered at most once per batch
+                        if (writeHeader && m_fileSize == 0)
+                        {
+                            if (m_header.empty())
+                            {
+                                const Lifetime::Use use{ *m_lifetime };
+                                std::ostringstream stream{};
+                                use.logger().writeHeaderToStream(stream);
+                                m_header = stream.str();
+                            }
+
+                            append(m_header);
+                        }
+
+                        m_index.add(fileIndexInterval, log->timestamp, m_fileSize);
+                        append(log->rendered);
+                    }
+
+                    syncFile();
+                    m_index.flush();
+                }
+                catch (const pluto::FileSystem::filesystem_error&)
+                {
+                    result = false;
+                }
+
+                return result;
+            }
+
+        private:
+            static void throwIOError(const int error)
+            {
+                throw pluto::FileSystem::filesystem_error{ "Logger failed to map file",
+                    std::error_code{ error, std::generic_category() } };
+            }
+
+            void syncFile()
+            {
+                if (shouldSync() && m_map != nullptr && ::msync(m_map, m_fileSize, MS_SYNC) != 0)
+                {
+                    throwIOError(errno);
+                }
+            }
+
+            void append(const std::string& text)
+            {
+                // Only a log bigger than a whole segment needs the mapping to grow
+                if (m_mapSize < (m_fileSize + text.size()))
+                {
+                    mapFile(m_fileSize + text.size());
+                }
+
+                std::memcpy(m_map + m_fileSize, text.data(), text.size());
+                m_fileSize += text.size();
+            }
+
+            void mapFile(const std::size_t minSize)
+            {
+                const auto segmentSize{ std::max(m_segmentSize, std::size_t{ 1 }) };
+                const auto mapSize{ std::max(((minSize + segmentSize - 1) / segmentSize), std::size_t{ 1 }) * segmentSize };
+
+                if (m_map != nullptr)
+                {
+                    ::munmap(m_map, m_mapSize);
+                    m_map = nullptr;
+                    m_mapSize = 0;
+                }
+
+                const auto error{ ::posix_fallocate(m_fd, 0, static_cast<off_t>(mapSize)) };
+                if (error != 0)
+                {
+                    throwIOError(error);
+                }
+
+                const auto map{ ::mmap(nullptr, mapSize, (PROT_READ | PROT_WRITE), MAP_SHARED, m_fd, 0) };
+                if (map == MAP_FAILED)
+                {
+                    throwIOError(errno);
+                }
+
+                m_map = static_cast<char*>(map);
+                m_mapSize = mapSize;
+            }
+
+            void openFile()
+            {
+                struct stat fileStat{};
+
+                m_fd = ::open(m_filePath.c_str(), (O_RDWR | O_CREAT | O_CLOEXEC), 0644);
+                if (m_fd == -1 || ::fstat(m_fd, &fileStat) != 0)
+                {
+                    closeFile();
+                    throw pluto::FileSystem::filesystem_error{ "Logger failed to open file",
+                        std::make_error_code(std::errc::io_error) };
+                }
+
+                try
+                {
+                    mapFile(static_cast<std::size_t>(fileStat.st_size));
+                }
+                catch (...)
+                {
+                    closeFile();
+                    throw;
+                }
+
+                // A crash leaves the rest of the segment zeroed, continue after the last logged byte
+                m_fileSize = static_cast<std::size_t>(fileStat.st_size);
+                while (m_fileSize != 0 && m_map[m_fileSize - 1] == '\0')
+                {
+                    --m_fileSize;
+                }
+            }
+
+            void closeFile()
+            {
+                if (m_map != nullptr)
+                {
+                    ::munmap(m_map, m_mapSize);
+                }
+
+                if (m_fd != -1)
+                {
+                    // Drop the unused part of the segment
+                    static_cast<void>(::ftruncate(m_fd, static_cast<off_t>(m_fileSize)));
+                    ::close(m_fd);
+                }
+
+                m_fd = -1;
+                m_map = nullptr;
+                m_mapSize = 0;
+                m_fileSize = 0;
+            }
+        };
+#endif
+
+        class OutputSink : public Sink
+        {
+            std::FILE* const m_file;
+
+        public:
+            OutputSink(const Output output) :
+                m_file{ (output == Output::Stderr) ? stderr : stdout } {}
+
+            bool write(const LogBatch& logs) override
+            {
+                for (const auto log : logs)
+                {
+                    std::fwrite(log->rendered.data(), sizeof(char), log->rendered.size(), m_file);
+                }
+
+                std::fflush(m_file);
+                return true;
+            }
+        };
+
+        class CallbackSink : public Sink
+        {
+            const RouteCallback m_callback;
+
+        public:
+            CallbackSink(const RouteCallback& callback) :
+                m_callback{ callback } {}
+
+            bool write(const LogBatch& logs) override
+            {
+                for (const auto log : logs)
+                {
+                    m_callback(log->level, log->rendered);
+                }
+
+                return true;
+            }
+        };
+
+    private:
+        class Stream
+        {
+            Logger* const       m_logger;
+            const std::string   m_logFileName;
+            const Level         m_logLevel;
+            const char* const   m_sourceFilePath;
+            const int           m_sourceLine;
+            const char* const   m_sourceFunction;
+            std::stringstream   m_stream;
+
+        public:
+            Stream(
+                Logger* const       logger,
+                const std::string   logFileName,
+                const Level         logLevel,
+                const char* const   sourceFilePath,
+                const int           sourceLine,
+                const char* const   sourceFunction) :
+                m_logger        { logger },
+                m_logFileName   { logFileName },
+                m_logLevel      { logLevel },
+                m_sourceFilePath{ sourceFilePath },
+                m_sourceLine    { sourceLine },
+                m_sourceFunction{ sourceFunction },
+                m_stream        {} {}
+
+            ~Stream()
+            {
+                try
+                {
+                    // The logger is null if the level was filtered out
+                    if (m_logger)
+                    {
+                        m_logger->addLogToBuffer(
+                            m_logFileName,
+                            m_logLevel,
+                            m_sourceFilePath,
+                            m_sourceLine,
+                            m_sourceFunction,
+#if (defined(__cplusplus) && __cplusplus > 201703L) || (defined(_MSVC_LANG) && _MSVC_LANG > 201703L)
+                            std::move(m_stream).str());
+#else
+                            m_stream.str());
+#endif
+                    }
+                }
+                catch (...) {}
+            }
+
+            Stream& operator<<(const bool b)
+            {
+                if (m_logger)
+                {
+                    m_stream << std::boolalpha << b;
+                }
+
+                return *this;
+            }
+
+            template<class T>
+            Stream& operator<<(const T& value)
+            {
+                if (m_logger)
+                {
+                    m_stream << value;
+                }
+
+                return *this;
+            }
+        };
+
+        typedef std::list<Log> LogBuffer;
+
+        struct Route
+        {
+            Level                   level;
+            std::shared_ptr<Sink>   sink;
+        };
+
+        struct LogFile
+        {
+            LogBuffer   buffer;
+            LogBuffer   recycled;       // Written logs waiting to be reused
+            std::size_t numAsyncWrites; // Logs in the buffer with waiters, written without waiting for the flush size
+            std::size_t writerIndex;    // Writer the file's logs go to, read from the entry in its home writer
+            std::size_t numFailedWrites;                    // In a row, the batch is retried after a backoff
+            std::chrono::steady_clock::time_point retryTime;
+
+            explicit LogFile(const std::size_t writerIndex = 0) :
+                buffer          {},
+                recycled        {},
+                numAsyncWrites  { 0 },
+                writerIndex     { writerIndex },
+                numFailedWrites { 0 },
+                retryTime       {} {}
+        };
+
+        // Settings a batch is rendered with, copied once per batch so rendering doesn't lock
+        struct RenderSettings
+        {
+            std::vector<MetaDataColumn> metaDataColumns {};
+            std::string                 separator       {};
+            std::string                 timestampFormat {};
+            std::string                 processIDColumn {};
+            LevelFormat                 levelFormat     { PLUTO_LOGGER_DEFAULT_LEVEL_FORMAT };
+            std::size_t                 timestampLength { 0 };
+            std::size_t                 fileNameLength  { 0 };
+            std::size_t                 lineLength      { 0 };
+            std::size_t                 functionLength  { 0 };
+        };
+
+        // Thread ID column for recent threads, rendered and padded once per writer. Each thread ID
+        // has one slot, so the cache stays the same size however many threads come and go.
+        struct ThreadIDColumns
+        {
+            static constexpr std::size_t numSlots{ 256 };
+
+            struct Slot
+            {
+                std::size_t id;     // 0 if empty, thread IDs start at 1
+                std::string text;
+            };
+
+            std::vector<Slot>           slots   {};
+            std::uint64_t               version { 0 };
+            std::size_t                 length  { 0 };
+        };
+
+        // Timestamp column formatted once per second by each writer. Fractions of a
+        // second (e.g. "%.6S") are left as zeros and filled in for each log.
+        struct TimestampColumn
+        {
+            std::time_t                                         second      { -1 };
+            std::string                                         format      {};
+            std::string                                         text        {};
+            std::vector<std::pair<std::size_t, std::size_t>>    fractions   {};     // Offset and precision in text
+        };
+
+        // Each writer thread owns the files hashed or assigned to it,
+        // so slow I/O on one file only stalls the files sharing its writer.
+        // Shared with its thread, so a thread left blocked in a sink at the shutdown timeout can
+        // return from it after the logger is gone. It then gives up on the batch's routes and stops.
+        struct Writer
+        {
+            std::mutex                      mutex           {};
+            std::thread                     thread          {};
+            std::condition_variable         condition       {};
+            std::condition_variable         doneCondition   {};
+            std::shared_ptr<Lifetime>       lifetime        {};
+            std::map<std::string, LogFile>  logFiles        {};
+            ThreadIDColumns                 threadIDColumns {};
+            RenderSettings                  renderSettings  {};             // Of the batch being written
+            TimestampColumn                 timestampColumn {};
+            std::uint64_t                   settingsVersion { 0 };          // Of the affinity and priority applied
+            const std::string*              writingFileName { nullptr };    // File of the batch being written unlocked
+            std::size_t                     numWriting      { 0 };          // Logs at the front of its buffer in that batch
+            bool                            isDone          { false };      // Every log was written after logging stopped
+            bool                            isAbandoned     { false };      // The logger stopped waiting, use it only through lifetime
+        };
+
+        // Names given with setThreadName by thread ID, shared by every logger. A name is forgotten
+        // once maxExitedNames more named threads have exited after its own, so logs the thread left
+        // in a buffer are still written with it but names don't build up as threads come and go.
+        struct ThreadNames
+        {
+            static constexpr std::size_t maxExitedNames{ 256 };
+
+            std::mutex                          mutex   {};
+            std::map<std::size_t, std::string>  names   {};
+            std::deque<std::size_t>             exited  {};
+            std::atomic<std::uint64_t>          version { 0 };
+        };
+
+        // Set up the first time a thread is named, see ThreadNames
+        struct ThreadNameExit
+        {
+            const std::size_t id;
+
+            ~ThreadNameExit()
+            {
+                auto& threadNames{ getThreadNames() };
+
+                const std::unique_lock<std::mutex> lock{ threadNames.mutex };
+
+                threadNames.exited.push_back(id);
+                if (ThreadNames::maxExitedNames < threadNames.exited.size())
+                {
+                    threadNames.names.erase(threadNames.exited.front());
+                    threadNames.exited.pop_front();
+                    ++threadNames.version;
+                }
+            }
+        };
+
+        const std::shared_ptr<Lifetime>         m_lifetime{ std::make_shared<Lifetime>(*this) };
+
+        // Names of the files in m_fileIDs by ID, published once so call sites check them without locking
+        const std::unique_ptr<std::atomic<const std::string*>[]> m_fileIDNames{
+            new std::atomic<const std::string*>[maxFileIDs]{} };
+        std::vector<std::shared_ptr<Writer>>    m_writers{};
+
+#ifdef _WIN32
+        const int m_processID{ _getpid() };
+#else
+        const int m_processID{ getpid() };
+#endif
+
+        std::atomic_bool            m_isLogging             { true };
+        std::atomic<Level>          m_level                 { PLUTO_LOGGER_DEFAULT_LEVEL };
+        std::atomic<std::uint64_t>  m_levelEpoch            { nextLevelEpoch() };
+        std::atomic_bool            m_hasLevelFilters       { false };
+        std::atomic<LevelFormat>    m_levelFormat           { PLUTO_LOGGER_DEFAULT_LEVEL_FORMAT };
+        std::atomic_bool            m_createDirs            { PLUTO_LOGGER_DEFAULT_CREATE_DIRS };
+        std::atomic_bool            m_writeHeader           { PLUTO_LOGGER_DEFAULT_WRITE_HEADER };
+        std::atomic_bool            m_writeHeaderUnderline  { PLUTO_LOGGER_DEFAULT_WRITE_HEADER_UNDERLINE };
+        std::atomic_char            m_headerUnderlineFill   { PLUTO_LOGGER_DEFAULT_HEADER_UNDERLINE_FILL };
+        std::atomic_size_t          m_bufferMaxSize         { PLUTO_LOGGER_DEFAULT_BUFFER_MAX_SIZE };
+        std::atomic_size_t          m_bufferFlushSize       { PLUTO_LOGGER_DEFAULT_BUFFER_FLUSH_SIZE };
+        std::atomic_size_t          m_bufferRecycleSize     { PLUTO_LOGGER_DEFAULT_BUFFER_RECYCLE_SIZE };
+        std::atomic_size_t          m_bufferRecycleCapacity { PLUTO_LOGGER_DEFAULT_BUFFER_RECYCLE_CAPACITY };
+        std::atomic_size_t          m_bufferMaxBatchSize    { PLUTO_LOGGER_DEFAULT_BUFFER_MAX_BATCH_SIZE };
+        std::atomic_size_t          m_writerWakeDelay       { PLUTO_LOGGER_DEFAULT_WRITER_WAKE_DELAY };
+        std::atomic_int             m_writerPriority        { PLUTO_LOGGER_DEFAULT_WRITER_PRIORITY };
+        std::atomic_bool            m_isWriterPrioritySet   { PLUTO_LOGGER_DEFAULT_WRITER_PRIORITY != 0 };
+        std::atomic<std::uint64_t>  m_writerSettingsVersion { m_isWriterPrioritySet.load() ? std::uint64_t{ 1 } : std::uint64_t{ 0 } };
+        std::atomic_size_t          m_fileRotationSize      { PLUTO_LOGGER_DEFAULT_FILE_ROTATION_SIZE };
+        std::atomic_size_t          m_fileRotationLimit     { PLUTO_LOGGER_DEFAULT_FILE_ROTATION_LIMIT };
+        std::atomic<FileRotationPeriod> m_fileRotationPeriod{ PLUTO_LOGGER_DEFAULT_FILE_ROTATION_PERIOD };
+        std::atomic_size_t          m_fileRetentionAge      { PLUTO_LOGGER_DEFAULT_FILE_RETENTION_AGE };
+        std::atomic_size_t          m_fileRetentionSize     { PLUTO_LOGGER_DEFAULT_FILE_RETENTION_SIZE };
+        std::atomic_size_t          m_fileIndexInterval     { PLUTO_LOGGER_DEFAULT_FILE_INDEX_INTERVAL };
+        std::atomic_size_t          m_fileMapSize           { PLUTO_LOGGER_DEFAULT_FILE_MAP_SIZE };
+        std::atomic_size_t          m_shutdownTimeout       { PLUTO_LOGGER_DEFAULT_SHUTDOWN_TIMEOUT };
+        std::atomic_size_t          m_numDiscardedLogs      { 0 };
+        std::atomic_size_t          m_timestampLength       { PLUTO_LOGGER_DEFAULT_TIMESTAMP_LENGTH };
+        std::atomic_size_t          m_processIDLength       { PLUTO_LOGGER_DEFAULT_PROCESS_ID_LENGTH };
+        std::atomic_size_t          m_threadIDLength        { PLUTO_LOGGER_DEFAULT_THREAD_ID_LENGTH };
+        std::atomic_size_t          m_fileNameLength        { PLUTO_LOGGER_DEFAULT_FILE_NAME_LENGTH };
+        std::atomic_size_t          m_lineLength            { PLUTO_LOGGER_DEFAULT_LINE_LENGTH };
+        std::atomic_size_t          m_functionLength        { PLUTO_LOGGER_DEFAULT_FUNCTION_LENGTH };
+
+        mutable std::mutex          m_configMutex               {};
+        std::string                 m_separator                 { PLUTO_LOGGER_DEFAULT_SEPARATOR };
+        std::string                 m_headerUnderlineSeparator  { PLUTO_LOGGER_DEFAULT_HEADER_UNDERLINE_SEPARATOR };
+        std::string                 m_timestampFormat           { PLUTO_LOGGER_DEFAULT_TIMESTAMP_FORMAT };
+        std::string                 m_timestampHeader           { PLUTO_LOGGER_DEFAULT_TIMESTAMP_HEADER };
+        std::string                 m_processIDHeader           { PLUTO_LOGGER_DEFAULT_PROCESS_ID_HEADER };
+        std::string                 m_threadIDHeader            { PLUTO_LOGGER_DEFAULT_THREAD_ID_HEADER };
+        std::string                 m_fileNameHeader            { PLUTO_LOGGER_DEFAULT_FILE_NAME_HEADER };
+        std::string                 m_lineHeader                { PLUTO_LOGGER_DEFAULT_LINE_HEADER };
+        std::string                 m_functionHeader            { PLUTO_LOGGER_DEFAULT_FUNCTION_HEADER };
+        std::string                 m_messageHeader             { PLUTO_LOGGER_DEFAULT_MESSAGE_HEADER };
+        std::vector<MetaDataColumn> m_metaDataColumns           { PLUTO_LOGGER_DEFAULT_META_DATA_COLUMNS };
+        std::string                 m_shutdownSpillFile         { PLUTO_LOGGER_DEFAULT_SHUTDOWN_SPILL_FILE };
+        std::vector<std::size_t>    m_writerAffinity            {};
+        bool                        m_isWriterAffinitySet       { false };
+        ShutdownCallback            m_shutdownCallback          {};
+
+        std::map<std::string, std::size_t>              m_writerIndexes {};
+        mutable std::map<std::string, std::size_t>      m_fileIDs       {};
+        std::map<std::string, Level>                    m_levelFilters  {};
+        std::map<std::string, std::vector<Route>>       m_routes        {};
+        std::map<std::string, std::shared_ptr<Sink>>    m_fileSinks     {};
+
+#if PLUTO_LOGGER_NO_SINGLETON
+    public:
+#endif
+        Logger(const std::size_t numWriters = PLUTO_LOGGER_DEFAULT_NUM_WRITERS)
+        {
+            // Create every writer before starting any thread, m_writers must not change afterwards
+            for (std::size_t i{ 0 }; i < std::max(numWriters, std::size_t{ 1 }); ++i)
+            {
+                m_writers.emplace_back(std::make_shared<Writer>());
+                m_writers.back()->lifetime = m_lifetime;
+            }
+
+            for (auto& writer : m_writers)
+            {
+                writer->thread = std::thread(&Logger::startLogging, this, writer);
+            }
+        }
+
+        // Writer threads write what's left in their buffers once logging stops. With a shutdown
+        // timeout, logs not written in time are spilled or discarded and any writer still blocked
+        // in a sink is detached, its batch is reported as not written. Only set one on loggers
+        // destroyed as the process exits.
+        ~Logger()
+        {
+            typedef std::chrono::steady_clock SteadyClock;
+
+            m_isLogging.store(false);
+            m_levelEpoch.store(nextLevelEpoch());
+
+            for (auto& writer : m_writers)
+            {
+                // Locking first means a writer about to wait sees logging stopped or gets the notification
+                {
+                    const std::unique_lock<std::mutex> lock{ writer->mutex };
+                }
+
+                writer->condition.notify_all();
+            }
+
+            const auto shutdownTimeout  { this->shutdownTimeout() };
+            const auto deadline         { SteadyClock::now() + std::chrono::milliseconds(shutdownTimeout) };
+            const auto progressInterval { std::chrono::milliseconds(100) };
+
+            ShutdownCallback callback{};
+            std::string spillFile{};
+
+            {
+                const std::unique_lock<std::mutex> lock{ m_configMutex };
+                callback = m_shutdownCallback;
+                spillFile = m_shutdownSpillFile;
+            }
+
+            const auto numLogs{ numUnwrittenLogs() };
+            const auto reportProgress{ [&](const std::size_t numRemaining)
+                {
+                    if (callback)
+                    {
+                        try
+                        {
+                            callback(((numRemaining < numLogs) ? (numLogs - numRemaining) : 0), numRemaining);
+                        }
+                        catch (...) {}
+                    }
+                } };
+
+            auto isTimedOut{ false };
+            for (auto& writer : m_writers)
+            {
+                std::unique_lock<std::mutex> lock{ writer->mutex };
+
+                while (!writer->isDone && !isTimedOut)
+                {
+                    auto wakeTime{ SteadyClock::now() + progressInterval };
+                    if (shutdownTimeout != 0 && deadline < wakeTime)
+                    {
+                        wakeTime = deadline;
+                    }
+
+                    writer->doneCondition.wait_until(lock, wakeTime);
+
+                    if (!writer->isDone)
+                    {
+                        if (shutdownTimeout != 0 && deadline <= SteadyClock::now())
+                        {
+                            isTimedOut = true;
+                        }
+                        else
+                        {
+                            lock.unlock();
+                            reportProgress(numUnwrittenLogs());
+                            lock.lock();
+                        }
+                    }
+                }
+            }
+
+            // Take the logs no writer got to, leaving any batch still being written
+            std::vector<std::pair<std::string, LogBuffer>> unwrittenLogs{};
+            std::size_t numUnwritten{ 0 };
+            std::size_t numAbandoned{ 0 };
+
+            for (auto& writer : m_writers)
+            {
+                auto isDone{ false };
+
+                {
+                    const std::unique_lock<std::mutex> lock{ writer->mutex };
+
+                    isDone = writer->isDone;
+                    if (!isDone)
+                    {
+                        writer->isAbandoned = true;
+
+                        for (auto& logFilePair : writer->logFiles)
+                        {
+                            auto& buffer{ logFilePair.second.buffer };
+                            auto begin  { buffer.begin() };
+
+                            // The batch stays with the blocked writer, so it isn't known to be written
+                            if (writer->writingFileName == &logFilePair.first)
+                            {
+                                numAbandoned += std::min(writer->numWriting, buffer.size());
+                                std::advance(begin, std::min(writer->numWriting, buffer.size()));
+                            }
+
+                            if (begin != buffer.end())
+                            {
+                                unwrittenLogs.emplace_back(logFilePair.first, LogBuffer{});
+
+                                auto& logs{ unwrittenLogs.back().second };
+                                logs.splice(logs.end(), buffer, begin, buffer.end());
+                                numUnwritten += logs.size();
+                            }
+                        }
+                    }
+                }
+
+                if (isDone)
+                {
+                    writer->thread.join();
+                }
+                else
+                {
+                    writer->thread.detach();
+                }
+            }
+
+            // Detached writers can't use the logger from here on
+            m_lifetime->end();
+
+            if (numUnwritten != 0 && (spillFile.empty() || !spillLogs(spillFile, unwrittenLogs)))
+            {
+                m_numDiscardedLogs += numUnwritten;
+            }
+
+            reportProgress(numUnwritten + numAbandoned);
+        }
+
+    public:
+        Logger(const Logger&) = delete;
+
+        void operator=(const Logger&) = delete;
+
+        static Logger& getInstance()
+        {
+            static Logger instance{};
+            return instance;
+        }
+
+        // Small ID for the calling thread, assigned the first time it's needed
+        static std::size_t threadID()
+        {
+            static std::atomic_size_t nextThreadID{ 1 };
+            thread_local const std::size_t id{ nextThreadID++ };
+            return id;
+        }
+
+        // Name shown in the thread ID column instead of the calling thread's ID
+        static void setThreadName(const std::string& name)
+        {
+            const auto id{ threadID() };
+            auto& threadNames{ getThreadNames() };
+            thread_local const ThreadNameExit threadNameExit{ id };
+
+            const std::unique_lock<std::mutex> lock{ threadNames.mutex };
+
+            threadNames.names[id] = name;
+            ++threadNames.version;
+        }
+
+        static std::string threadName(const std::size_t id)
+        {
+            auto& threadNames{ getThreadNames() };
+
+            const std::unique_lock<std::mutex> lock{ threadNames.mutex };
+
+            const auto it{ threadNames.names.find(id) };
+            if (it != threadNames.names.end() && !it->second.empty())
+            {
+                return it->second;
+            }
+
+            return std::to_string(id);
+        }
+
+        static inline std::string getLocalTimestamp(const char* const format)
+        {
+            return getLocalTimestamp(format, Clock::now());
+        }
+
+        static inline std::string getLocalTimestamp(const char* const format, const Clock::time_point nowTime)
+        {
+            const auto nowPosixTime{ Clock::to_time_t(nowTime) };
+
+            std::tm nowLocalTime{};
+#ifdef _WIN32
+            if (localtime_s(&nowLocalTime, &nowPosixTime) == 0)
+#else
+            if (localtime_r(&nowPosixTime, &nowLocalTime) != nullptr)
+#endif
+            {
+                std::string formatCopy{ format };
+
+                for (std::size_t i{ 0 }; (i + 3) < formatCopy.size(); ++i)
+                {
+                    if (formatCopy[i] == '%' && formatCopy[i + 1] == '.' && formatCopy[i + 3] == 'S')
+                    {
+                        const auto precision{ static_cast<std::size_t>(formatCopy[i + 2]) - '0' };
+
+                        if (0 < precision && precision < 10)
+                        {
+                            const auto nowNanoseconds{ std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                nowTime.time_since_epoch()).count() % 1'000'000'000 };
+
+                            formatCopy.replace(i, 4, std::to_string(nowNanoseconds), 0, precision);
+                        }
+                    }
+                }
+
+                std::ostringstream ss{};
+                ss << std::put_time(&nowLocalTime, formatCopy.c_str());
                 return ss.str();
             }
 
-            return {};
+            return {};
+        }
+
+        static inline std::string getFileName(const char* const filePath)
+        {
+            return pluto::FileSystem::path{ filePath }.filename().string();
+        }
+
+        static pluto::FileSystem::path getIndexFilePath(const pluto::FileSystem::path& filePath)
+        {
+            return (filePath.string() + ".idx");
+        }
+
+        // File that logs at timestamp go to for the rotation period, and when the next period starts
+        static pluto::FileSystem::path getPeriodFilePath(
+            const pluto::FileSystem::path&  filePath,
+            const FileRotationPeriod        period,
+            const Clock::time_point         timestamp,
+            Clock::time_point&              nextRotationTime)
+        {
+            if (period == FileRotationPeriod::None)
+            {
+                nextRotationTime = Clock::time_point::max();
+                return filePath;
+            }
+
+            const auto posixTime{ Clock::to_time_t(timestamp) };
+
+            std::tm localTime{};
+#ifdef _WIN32
+            localtime_s(&localTime, &posixTime);
+#else
+            localtime_r(&posixTime, &localTime);
+#endif
+            localTime.tm_min = 0;
+            localTime.tm_sec = 0;
+
+            if (period == FileRotationPeriod::Daily)
+            {
+                localTime.tm_hour = 0;
+            }
+
+            char stamp[32]{};
+            std::strftime(stamp, sizeof(stamp),
+                ((period == FileRotationPeriod::Daily) ? "%Y-%m-%d" : "%Y-%m-%dT%H"), &localTime);
+
+            // mktime normalizes the next hour or day, daylight saving included
+            if (period == FileRotationPeriod::Daily)
+            {
+                ++localTime.tm_mday;
+            }
+            else
+            {
+                ++localTime.tm_hour;
+            }
+
+            localTime.tm_isdst = -1;
+            nextRotationTime = Clock::from_time_t(std::mktime(&localTime));
+
+            if (nextRotationTime <= timestamp)
+            {
+                nextRotationTime = timestamp + std::chrono::hours(1);
+            }
+
+            return (filePath.parent_path() /
+                (filePath.stem().string() + "." + stamp + filePath.extension().string()));
+        }
+
+        static inline std::string levelToString(const Level level, const LevelFormat levelFormat)
+        {
+            switch (levelFormat)
+            {
+                case LevelFormat::Full:
+                    switch (level)
+                    {
+                        case Level::None:       return "        ";
+                        case Level::Fatal:      return "Fatal   ";
+                        case Level::Critical:   return "Critical";
+                        case Level::Error:      return "Error   ";
+                        case Level::Warning:    return "Warning ";
+                        case Level::Notice:     return "Notice  ";
+                        case Level::Info:       return "Info    ";
+                        case Level::Debug:      return "Debug   ";
+                        case Level::Trace:      return "Trace   ";
+                        case Level::Verbose:    return "Verbose ";
+                        case Level::Header:     return "Level   ";
+                        default:                return "Unknown ";
+                    }
+
+                case LevelFormat::Short:
+                    switch (level)
+                    {
+                        case Level::None:       return "   ";
+                        case Level::Fatal:      return "FTL";
+                        case Level::Critical:   return "CRT";
+                        case Level::Error:      return "ERR";
+                        case Level::Warning:    return "WRN";
+                        case Level::Notice:     return "NTC";
+                        case Level::Info:       return "INF";
+                        case Level::Debug:      return "DBG";
+                        case Level::Trace:      return "TRC";
+                        case Level::Verbose:    return "VRB";
+                        case Level::Header:     return "LVL";
+                        default:                return "UNK";
+                    }
+
+                case LevelFormat::Char:
+                    switch (level)
+                    {
+                        case Level::None:       return " ";
+                        case Level::Fatal:      return "F";
+                        case Level::Critical:   return "C";
+                        case Level::Error:      return "E";
+                        case Level::Warning:    return "W";
+                        case Level::Notice:     return "N";
+                        case Level::Info:       return "I";
+                        case Level::Debug:      return "D";
+                        case Level::Trace:      return "T";
+                        case Level::Verbose:    return "V";
+                        case Level::Header:     return "L";
+                        default:                return "?";
+                    }
+
+                default: return "Bad Format";
+            }
+        }
+
+        int processID()                 const   { return m_processID; }
+        bool isLogging()                const   { return m_isLogging.load(); }
+        Level level()                   const   { return m_level.load(); }
+        LevelFormat levelFormat()       const   { return m_levelFormat.load(); }
+        bool createDirs()               const   { return m_createDirs.load(); }
+        bool writeHeader()              const   { return m_writeHeader.load(); }
+        bool writeHeaderUnderline()     const   { return m_writeHeaderUnderline.load(); }
+        char headerUnderlineFill()      const   { return m_headerUnderlineFill.load(); }
+        std::size_t bufferMaxSize()     const   { return m_bufferMaxSize.load(); }
+        std::size_t bufferFlushSize()   const   { return m_bufferFlushSize.load(); }
+        std::size_t bufferRecycleSize() const   { return m_bufferRecycleSize.load(); }
+        std::size_t bufferRecycleCapacity() const { return m_bufferRecycleCapacity.load(); }
+        std::size_t bufferMaxBatchSize() const  { return m_bufferMaxBatchSize.load(); }
+        std::size_t writerWakeDelay()   const   { return m_writerWakeDelay.load(); }
+        int writerPriority()            const   { return m_writerPriority.load(); }
+        std::size_t fileRotationSize()  const   { return m_fileRotationSize.load(); }
+        std::size_t fileRotationLimit() const   { return m_fileRotationLimit.load(); }
+        FileRotationPeriod fileRotationPeriod() const { return m_fileRotationPeriod.load(); }
+        std::size_t fileRetentionAge()  const   { return m_fileRetentionAge.load(); }
+        std::size_t fileRetentionSize() const   { return m_fileRetentionSize.load(); }
+        std::size_t fileIndexInterval() const   { return m_fileIndexInterval.load(); }
+        std::size_t fileMapSize()       const   { return m_fileMapSize.load(); }
+        std::size_t shutdownTimeout()   const   { return m_shutdownTimeout.load(); }
+        std::size_t numDiscardedLogs()  const   { return m_numDiscardedLogs.load(); }
+        std::size_t timestampLength()   const   { return m_timestampLength.load(); }
+        std::size_t processIDLength()   const   { return m_processIDLength.load(); }
+        std::size_t threadIDLength()    const   { return m_threadIDLength.load(); }
+        std::size_t fileNameLength()    const   { return m_fileNameLength.load(); }
+        std::size_t lineLength()        const   { return m_lineLength.load(); }
+        std::size_t functionLength()    const   { return m_functionLength.load(); }
+        std::size_t numWriters()        const   { return m_writers.size(); }
+
+        std::size_t writerIndex(const std::string& logFileName) const
+        {
+            if (m_writers.size() == 1)
+            {
+                return 0;
+            }
+
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+
+            const auto it{ m_writerIndexes.find(logFileName) };
+            if (it != m_writerIndexes.end())
+            {
+                return it->second;
+            }
+
+            return homeWriterIndex(logFileName);
+        }
+
+        std::string separator() const
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            return m_separator;
+        }
+
+        std::string headerUnderlineSeparator() const
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            return m_headerUnderlineSeparator;
+        }
+
+        std::string timestampFormat() const
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            return m_timestampFormat;
+        }
+
+        std::string timestampHeader() const
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            return m_timestampHeader;
+        }
+
+        std::string processIDHeader() const
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            return m_processIDHeader;
+        }
+
+        std::string threadIDHeader() const
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            return m_threadIDHeader;
+        }
+
+        std::string fileNameHeader() const
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            return m_fileNameHeader;
+        }
+
+        std::string lineHeader() const
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            return m_lineHeader;
+        }
+
+        std::string functionHeader() const
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            return m_functionHeader;
+        }
+
+        std::string messageHeader() const
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            return m_messageHeader;
+        }
+
+        std::vector<MetaDataColumn> metaDataColumns() const
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            return m_metaDataColumns;
+        }
+
+        std::string shutdownSpillFile() const
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            return m_shutdownSpillFile;
+        }
+
+        std::vector<std::size_t> writerAffinity() const
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            return m_writerAffinity;
+        }
+        
+        Logger& level(const Level l)                { m_level.store(l); m_levelEpoch.store(nextLevelEpoch()); return *this; }
+        Logger& levelFormat(const LevelFormat lf)   { m_levelFormat.store(lf);          return *this; }
+        Logger& createDirs(const bool b)            { m_createDirs.store(b);            return *this; }
+        Logger& writeHeader(const bool b)           { m_writeHeader.store(b);           return *this; }
+        Logger& writeHeaderUnderline(const bool b)  { m_writeHeaderUnderline.store(b);  return *this; }
+        Logger& headerUnderlineFill(const char c)   { m_headerUnderlineFill.store(c);   return *this; }
+        Logger& bufferMaxSize(const std::size_t s)  { m_bufferMaxSize.store(s);         return *this; }
+
+        Logger& bufferFlushSize(const std::size_t s)
+        {
+            m_bufferFlushSize.store(s);
+            notifyWriters();
+            return *this;
+        }
+
+        Logger& bufferRecycleSize(const std::size_t s)  { m_bufferRecycleSize.store(s); return *this; }
+        Logger& bufferRecycleCapacity(const std::size_t c) { m_bufferRecycleCapacity.store(c); return *this; }
+        Logger& bufferMaxBatchSize(const std::size_t s) { m_bufferMaxBatchSize.store(s); return *this; }
+        Logger& writerWakeDelay(const std::size_t s)    { m_writerWakeDelay.store(s);   return *this; }
+        Logger& fileRotationSize(const std::size_t s)   { m_fileRotationSize.store(s);  return *this; }
+        Logger& fileRotationLimit(const std::size_t s)  { m_fileRotationLimit.store(s); return *this; }
+        Logger& fileRotationPeriod(const FileRotationPeriod p) { m_fileRotationPeriod.store(p); return *this; }
+        Logger& fileRetentionAge(const std::size_t s)   { m_fileRetentionAge.store(s);  return *this; }
+        Logger& fileRetentionSize(const std::size_t s)  { m_fileRetentionSize.store(s); return *this; }
+        Logger& fileIndexInterval(const std::size_t s)  { m_fileIndexInterval.store(s); return *this; }
+        Logger& fileMapSize(const std::size_t s)        { m_fileMapSize.store(s);       return *this; }
+        Logger& shutdownTimeout(const std::size_t s)    { m_shutdownTimeout.store(s);   return *this; }
+        Logger& resetNumDiscardedLogs()                 { m_numDiscardedLogs.store(0);  return *this; }
+        Logger& timestampLength(const std::size_t s)    { m_timestampLength.store(s);   return *this; }
+        Logger& processIDLength(const std::size_t s)    { m_processIDLength.store(s);   return *this; }
+        Logger& threadIDLength(const std::size_t s)     { m_threadIDLength.store(s);    return *this; }
+        Logger& fileNameLength(const std::size_t s)     { m_fileNameLength.store(s);    return *this; }
+        Logger& lineLength(const std::size_t s)         { m_lineLength.store(s);        return *this; }
+        Logger& functionLength(const std::size_t s)     { m_functionLength.store(s);    return *this; }
+        
+        Logger& separator(const std::string& s)
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            m_separator = s;
+            return *this;
+        }
+
+        Logger& headerUnderlineSeparator(const std::string& s)
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            m_headerUnderlineSeparator = s;
+            return *this;
+        }
+
+        Logger& timestampFormat(const std::string& s)
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            m_timestampFormat = s;
+            return *this;
+        }
+
+        Logger& timestampHeader(const std::string& s)
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            m_timestampHeader = s;
+            return *this;
+        }
+
+        Logger& processIDHeader(const std::string& s)
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            m_processIDHeader = s;
+            return *this;
+        }
+
+        Logger& threadIDHeader(const std::string& s)
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            m_threadIDHeader = s;
+            return *this;
         }
 
-        static inline std::string getFileName(const char* const filePath)
+        Logger& fileNameHeader(const std::string& s)
         {
-            return pluto::FileSystem::path{ filePath }.filename().string();
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            m_fileNameHeader = s;
+            return *this;
         }
 
-        static inline std::string levelToString(const Level level, const LevelFormat levelFormat)
+        Logger& lineHeader(const std::string& s)
         {
-            switch (levelFormat)
-            {
-                case LevelFormat::Full:
-                    switch (level)
-                    {
-                        case Level::None:       return "        ";
-                        case Level::Fatal:      return "Fatal   ";
-                        case Level::Critical:   return "Critical";
-                        case Level::Error:      return "Error   ";
-                        case Level::Warning:    return "Warning ";
-                        case Level::Notice:     return "Notice  ";
-                        case Level::Info:       return "Info    ";
-                        case Level::Debug:      return "Debug   ";
-                        case Level::Trace:      return "Trace   ";
-                        case Level::Verbose:    return "Verbose ";
-                        case Level::Header:     return "Level   ";
-                        default:                return "Unknown ";
-                    }
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            m_lineHeader = s;
+            return *this;
+        }
 
-                case LevelFormat::Short:
-                    switch (level)
-                    {
-                        case Level::None:       return "   ";
-                        case Level::Fatal:      return "FTL";
-                        case Level::Critical:   return "CRT";
-                        case Level::Error:      return "ERR";
-                        case Level::Warning:    return "WRN";
-                        case Level::Notice:     return "NTC";
-                        case Level::Info:       return "INF";
-                        case Level::Debug:      return "DBG";
-                        case Level::Trace:      return "TRC";
-                        case Level::Verbose:    return "VRB";
-                        case Level::Header:     return "LVL";
-                        default:                return "UNK";
-                    }
+        Logger& functionHeader(const std::string& s)
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            m_functionHeader = s;
+            return *this;
+        }
 
-                case LevelFormat::Char:
-                    switch (level)
-                    {
-                        case Level::None:       return " ";
-                        case Level::Fatal:      return "F";
-                        case Level::Critical:   return "C";
-                        case Level::Error:      return "E";
-                        case Level::Warning:    return "W";
-                        case Level::Notice:     return "N";
-                        case Level::Info:       return "I";
-                        case Level::Debug:      return "D";
-                        case Level::Trace:      return "T";
-                        case Level::Verbose:    return "V";
-                        case Level::Header:     return "L";
-                        default:                return "?";
-                    }
+        Logger& messageHeader(const std::string& s)
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            m_messageHeader = s;
+            return *this;
+        }
 
-                default: return "Bad Format";
+        Logger& metaDataColumns(const std::vector<MetaDataColumn>& v)
+        {
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            m_metaDataColumns = v;
+            return *this;
+        }
+
+        template<typename ...Ts>
+        Logger& metaDataColumns(const Ts... ts)
+        {
+            return metaDataColumns({ ts... });
+        }
+
+        // CPUs the writer threads may run on, empty means any (Linux only).
+        // Each writer applies it the next time it wakes, until then it keeps the affinity it inherited.
+        Logger& writerAffinity(const std::vector<std::size_t>& cpus)
+        {
+            {
+                const std::unique_lock<std::mutex> lock{ m_configMutex };
+                m_writerAffinity = cpus;
+                m_isWriterAffinitySet = true;
             }
+
+            ++m_writerSettingsVersion;
+            notifyWriters();
+            return *this;
         }
 
-        int processID()                 const   { return m_processID; }
-        bool isLogging()                const   { return m_isLogging.load(); }
-        Level level()                   const   { return m_level.load(); }
-        LevelFormat levelFormat()       const   { return m_levelFormat.load(); }
-        bool createDirs()               const   { return m_createDirs.load(); }
-        bool writeHeader()              const   { return m_writeHeader.load(); }
-        bool writeHeaderUnderline()     const   { return m_writeHeaderUnderline.load(); }
-        char headerUnderlineFill()      const   { return m_headerUnderlineFill.load(); }
-        std::size_t bufferMaxSize()     const   { return m_bufferMaxSize.load(); }
-        std::size_t bufferFlushSize()   const   { return m_bufferFlushSize.load(); }
-        std::size_t fileRotationSize()  const   { return m_fileRotationSize.load(); }
-        std::size_t fileRotationLimit() const   { return m_fileRotationLimit.load(); }
-        std::size_t numDiscardedLogs()  const   { return m_numDiscardedLogs.load(); }
-        std::size_t timestampLength()   const   { return m_timestampLength.load(); }
-        std::size_t processIDLength()   const   { return m_processIDLength.load(); }
-        std::size_t threadIDLength()    const   { return m_threadIDLength.load(); }
-        std::size_t fileNameLength()    const   { return m_fileNameLength.load(); }
-        std::size_t lineLength()        const   { return m_lineLength.load(); }
-        std::size_t functionLength()    const   { return m_functionLength.load(); }
+        // Like writerAffinity, writers keep the priority they inherited until this is called
+        Logger& writerPriority(const int nice)
+        {
+            m_writerPriority.store(nice);
+            m_isWriterPrioritySet.store(true);
+            ++m_writerSettingsVersion;
+            notifyWriters();
+            return *this;
+        }
 
-        std::string separator() const
+        // Logs left at the shutdown timeout are appended to this file, each prefixed with its log file name
+        Logger& shutdownSpillFile(const std::string& s)
         {
             const std::unique_lock<std::mutex> lock{ m_configMutex };
-            return m_separator;
+            m_shutdownSpillFile = s;
+            return *this;
         }
 
-        std::string headerUnderlineSeparator() const
+        // Called from the destructor while it waits for the writers, and once more when done
+        Logger& shutdownCallback(const ShutdownCallback& callback)
         {
             const std::unique_lock<std::mutex> lock{ m_configMutex };
-            return m_headerUnderlineSeparator;
+            m_shutdownCallback = callback;
+            return *this;
         }
 
-        std::string timestampFormat() const
+        // Also write logs from logFileName at or above level to routeFileName.
+        // Each log is still buffered and rendered once no matter how many routes it matches.
+        Logger& route(const std::string& logFileName, const Level level, const std::string& routeFileName)
         {
             const std::unique_lock<std::mutex> lock{ m_configMutex };
-            return m_timestampFormat;
+            m_routes[logFileName].push_back({ level, getFileSink(routeFileName) });
+            return *this;
         }
 
-        std::string timestampHeader() const
+        Logger& route(const std::string& logFileName, const Level level, const Output output)
         {
             const std::unique_lock<std::mutex> lock{ m_configMutex };
-            return m_timestampHeader;
+            m_routes[logFileName].push_back({ level, std::make_shared<OutputSink>(output) });
+            return *this;
         }
 
-        std::string processIDHeader() const
+        // The callback is called from a writer thread with each rendered log
+        Logger& route(const std::string& logFileName, const Level level, const RouteCallback& callback)
         {
             const std::unique_lock<std::mutex> lock{ m_configMutex };
-            return m_processIDHeader;
+            m_routes[logFileName].push_back({ level, std::make_shared<CallbackSink>(callback) });
+            return *this;
         }
 
-        std::string threadIDHeader() const
+        Logger& route(const std::string& logFileName, const Level level, const std::shared_ptr<Sink>& sink)
         {
             const std::unique_lock<std::mutex> lock{ m_configMutex };
-            return m_threadIDHeader;
+            m_routes[logFileName].push_back({ level, sink });
+            return *this;
         }
 
-        std::string fileNameHeader() const
+        Logger& clearRoutes(const std::string& logFileName)
         {
             const std::unique_lock<std::mutex> lock{ m_configMutex };
-            return m_fileNameHeader;
+            m_routes.erase(logFileName);
+            return *this;
         }
 
-        std::string lineHeader() const
+        // Send logs written or routed to logFileName to a custom sink instead of the file.
+        // Pass nullptr to go back to writing the file.
+        Logger& sink(const std::string& logFileName, const std::shared_ptr<Sink>& sink)
         {
             const std::unique_lock<std::mutex> lock{ m_configMutex };
-            return m_lineHeader;
+
+            if (sink)
+            {
+                m_fileSinks[logFileName] = sink;
+            }
+            else
+            {
+                m_fileSinks.erase(logFileName);
+            }
+
+            return *this;
         }
 
-        std::string functionHeader() const
+        // Set the level for log files or source files matching pattern, where '*' matches any
+        // characters and '?' matches one. When several patterns match, an exact name is used
+        // over any pattern with wildcards, otherwise the longest pattern is used.
+        Logger& level(const std::string& pattern, const Level l)
         {
             const std::unique_lock<std::mutex> lock{ m_configMutex };
-            return m_functionHeader;
+            m_levelFilters[pattern] = l;
+            m_hasLevelFilters.store(true);
+            m_levelEpoch.store(nextLevelEpoch());
+            return *this;
         }
 
-        std::string messageHeader() const
+        Logger& clearLevels()
         {
             const std::unique_lock<std::mutex> lock{ m_configMutex };
-            return m_messageHeader;
+            m_levelFilters.clear();
+            m_hasLevelFilters.store(false);
+            m_levelEpoch.store(nextLevelEpoch());
+            return *this;
         }
 
-        std::vector<MetaDataColumn> metaDataColumns() const
+        // Assign a log file to a writer thread instead of hashing its name.
+        // Assign before logging to the file, logs already buffered stay with their current writer.
+        Logger& writerIndex(const std::string& logFileName, const std::size_t index)
         {
+            auto& home{ *m_writers[homeWriterIndex(logFileName)] };
+
+            // Same order as the writers, which read settings with their own mutex locked
+            const std::unique_lock<std::mutex> writerLock{ home.mutex };
             const std::unique_lock<std::mutex> lock{ m_configMutex };
-            return m_metaDataColumns;
+
+            m_writerIndexes[logFileName] = (index % m_writers.size());
+
+            const auto it{ home.logFiles.find(logFileName) };
+            if (it != home.logFiles.end())
+            {
+                it->second.writerIndex = m_writerIndexes[logFileName];
+            }
+
+            return *this;
         }
-        
-        Logger& level(const Level l)                { m_level.store(l);                 return *this; }
-        Logger& levelFormat(const LevelFormat lf)   { m_levelFormat.store(lf);          return *this; }
-        Logger& createDirs(const bool b)            { m_createDirs.store(b);            return *this; }
-        Logger& writeHeader(const bool b)           { m_writeHeader.store(b);           return *this; }
-        Logger& writeHeaderUnderline(const bool b)  { m_writeHeaderUnderline.store(b);  return *this; }
-        Logger& headerUnderlineFill(const char c)   { m_headerUnderlineFill.store(c);   return *this; }
-        Logger& bufferMaxSize(const std::size_t s)  { m_bufferMaxSize.store(s);         return *this; }
 
-        Logger& bufferFlushSize(const std::size_t s)
+        // Level used for logs to logFileName from sourceFilePath after applying level patterns
+        Level level(const std::string& logFileName, const char* const sourceFilePath = "") const
+        {
+            if (!m_hasLevelFilters.load())
+            {
+                return level();
+            }
+
+            const auto sourceFileName{ getFileName((sourceFilePath == nullptr) ? "" : sourceFilePath) };
+
+            const std::unique_lock<std::mutex> lock{ m_configMutex };
+
+            auto result{ level() };
+            std::size_t resultRank{ 0 };
+
+            for (const auto& levelFilter : m_levelFilters)
+            {
+                const auto& pattern{ levelFilter.first };
+                const auto rank{ (pattern.find_first_of("*?") == std::string::npos) ?
+                    std::string::npos : pattern.size() };
+
+                if (resultRank <= rank &&
+                    (matchesPattern(pattern, logFileName) || matchesPattern(pattern, sourceFileName)))
+                {
+                    result = levelFilter.second;
+                    resultRank = rank;
+                }
+            }
+
+            return result;
+        }
+
+        bool shouldLog(const Level logLevel) const
+        {
+            return (isLogging() && logLevel <= level());
+        }
+
+        bool shouldLog(const Level logLevel, const std::string& logFileName, const char* const sourceFilePath) const
+        {
+            return (isLogging() && logLevel <= level(logFileName, sourceFilePath));
+        }
+
+        // Only resolves the level when the call site's cache is from an old epoch or another log file.
+        // Without level patterns there's nothing to resolve, so the cache isn't used.
+        bool shouldLog(
+            CallSite&           callSite,
+            const Level         logLevel,
+            const std::string&  logFileName,
+            const char* const   sourceFilePath) const
+        {
+            if (!m_hasLevelFilters.load(std::memory_order_relaxed))
+            {
+                return shouldLog(logLevel);
+            }
+
+            const auto epoch{ m_levelEpoch.load(std::memory_order_relaxed) };
+            const auto cache{ callSite.m_cache.load(std::memory_order_relaxed) };
+
+            if ((cache & ~std::uint64_t{ 0xFFFFFF }) == CallSite::key(epoch, 0))
+            {
+                const auto fileName{ m_fileIDNames[(cache >> 8) & 0xFFFF].load(std::memory_order_acquire) };
+
+                if (fileName != nullptr && *fileName == logFileName)
+                {
+                    return (logLevel <= static_cast<Level>(cache & 0xFF));
+                }
+            }
+
+            const auto resolvedLevel{ isLogging() ? level(logFileName, sourceFilePath) : Level::Off };
+            const auto fileID{ this->fileID(logFileName) };
+
+            if (fileID < maxFileIDs)
+            {
+                callSite.m_cache.store((CallSite::key(epoch, fileID) | static_cast<std::uint64_t>(resolvedLevel)),
+                    std::memory_order_relaxed);
+            }
+
+            return (logLevel <= resolvedLevel);
+        }
+
+        void writef(
+            const std::string&  logFileName,
+            const Level         logLevel,
+            const char* const   sourceFilePath,
+            const int           sourceLine,
+            const char* const   sourceFunction,
+            const char* const   format,
+            ...)
+        {
+            if (shouldLog(logLevel, logFileName, sourceFilePath))
+            {
+                va_list args;
+                va_start(args, format);
+                writeFormatted(logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction, format, args);
+                va_end(args);
+            }
+        }
+
+        void writef(
+            CallSite&           callSite,
+            const std::string&  logFileName,
+            const Level         logLevel,
+            const char* const   sourceFilePath,
+            const int           sourceLine,
+            const char* const   sourceFunction,
+            const char* const   format,
+            ...)
+        {
+            if (shouldLog(callSite, logLevel, logFileName, sourceFilePath))
+            {
+                va_list args;
+                va_start(args, format);
+                writeFormatted(logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction, format, args);
+                va_end(args);
+            }
+        }
+
+        void write(
+            const std::string&  logFileName,
+            const Level         logLevel,
+            const char* const   sourceFilePath,
+            const int           sourceLine,
+            const char* const   sourceFunction,
+            const std::string&  message)
         {
-            m_bufferFlushSize.store(s);
-            m_loggingThreadCondition.notify_one();  // wake the logging thread
-            return *this;
+            if (shouldLog(logLevel, logFileName, sourceFilePath))
+            {
+                addLogToBuffer(logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction, message);
+            }
         }
 
-        Logger& fileRotationSize(const std::size_t s)   { m_fileRotationSize.store(s);  return *this; }
-        Logger& fileRotationLimit(const std::size_t s)  { m_fileRotationLimit.store(s); return *this; }
-        Logger& resetNumDiscardedLogs()                 { m_numDiscardedLogs.store(0);  return *this; }
-        Logger& timestampLength(const std::size_t s)    { m_timestampLength.store(s);   return *this; }
-        Logger& processIDLength(const std::size_t s)    { m_processIDLength.store(s);   return *this; }
-        Logger& threadIDLength(const std::size_t s)     { m_threadIDLength.store(s);    return *this; }
-        Logger& fileNameLength(const std::size_t s)     { m_fileNameLength.store(s);    return *this; }
-        Logger& lineLength(const std::size_t s)         { m_lineLength.store(s);        return *this; }
-        Logger& functionLength(const std::size_t s)     { m_functionLength.store(s);    return *this; }
-        
-        Logger& separator(const std::string& s)
+        void write(
+            const std::string&  logFileName,
+            const Level         logLevel,
+            const char* const   sourceFilePath,
+            const int           sourceLine,
+            const char* const   sourceFunction,
+            std::string&&       message)
         {
-            const std::unique_lock<std::mutex> lock{ m_configMutex };
-            m_separator = s;
-            return *this;
+            if (shouldLog(logLevel, logFileName, sourceFilePath))
+            {
+                addLogToBuffer(logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction, std::move(message));
+            }
         }
 
-        Logger& headerUnderlineSeparator(const std::string& s)
+        void write(
+            CallSite&           callSite,
+            const std::string&  logFileName,
+            const Level         logLevel,
+            const char* const   sourceFilePath,
+            const int           sourceLine,
+            const char* const   sourceFunction,
+            const std::string&  message)
         {
-            const std::unique_lock<std::mutex> lock{ m_configMutex };
-            m_headerUnderlineSeparator = s;
-            return *this;
+            if (shouldLog(callSite, logLevel, logFileName, sourceFilePath))
+            {
+                addLogToBuffer(logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction, message);
+            }
         }
 
-        Logger& timestampFormat(const std::string& s)
+        void write(
+            CallSite&           callSite,
+            const std::string&  logFileName,
+            const Level         logLevel,
+            const char* const   sourceFilePath,
+            const int           sourceLine,
+            const char* const   sourceFunction,
+            std::string&&       message)
         {
-            const std::unique_lock<std::mutex> lock{ m_configMutex };
-            m_timestampFormat = s;
-            return *this;
+            if (shouldLog(callSite, logLevel, logFileName, sourceFilePath))
+            {
+                addLogToBuffer(logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction, std::move(message));
+            }
         }
 
-        Logger& timestampHeader(const std::string& s)
+        // Logs with a timestamp taken by the caller, e.g. when forwarding logs from elsewhere. Logs
+        // are still written in the order they're queued, one timestamped before the log ahead of it
+        // goes in the same file after it.
+        void write(
+            const Clock::time_point timestamp,
+            const std::string&      logFileName,
+            const Level             logLevel,
+            const char* const       sourceFilePath,
+            const int               sourceLine,
+            const char* const       sourceFunction,
+            std::string             message)
         {
-            const std::unique_lock<std::mutex> lock{ m_configMutex };
-            m_timestampHeader = s;
-            return *this;
+            if (shouldLog(logLevel, logFileName, sourceFilePath))
+            {
+                addLogToBuffer(timestamp, logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction, std::move(message));
+            }
         }
 
-        Logger& processIDHeader(const std::string& s)
+        // The future gives true once the log is written, and synced if sync is true.
+        // It gives false if the log was filtered out, discarded or couldn't be written.
+        std::future<bool> writeAsync(
+            const std::string&  logFileName,
+            const Level         logLevel,
+            const char* const   sourceFilePath,
+            const int           sourceLine,
+            const char* const   sourceFunction,
+            std::string         message,
+            const bool          sync = false)
         {
-            const std::unique_lock<std::mutex> lock{ m_configMutex };
-            m_processIDHeader = s;
-            return *this;
-        }
+            auto asyncWrite{ std::make_shared<AsyncWrite>(sync) };
+            auto future{ asyncWrite->getFuture() };
 
-        Logger& threadIDHeader(const std::string& s)
-        {
-            const std::unique_lock<std::mutex> lock{ m_configMutex };
-            m_threadIDHeader = s;
-            return *this;
+            addAsyncLog(logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction, std::move(message), asyncWrite);
+            return future;
         }
 
-        Logger& fileNameHeader(const std::string& s)
+#if PLUTO_LOGGER_HAS_COROUTINES
+        // Like writeAsync for coroutines. The coroutine resumes on the writer thread,
+        // so move anything slow to another thread to avoid holding up logging.
+        WriteAwaiter awaitWrite(
+            const std::string&  logFileName,
+            const Level         logLevel,
+            const char* const   sourceFilePath,
+            const int           sourceLine,
+            const char* const   sourceFunction,
+            std::string         message,
+            const bool          sync = false)
         {
-            const std::unique_lock<std::mutex> lock{ m_configMutex };
-            m_fileNameHeader = s;
-            return *this;
+            auto asyncWrite{ std::make_shared<AsyncWrite>(sync) };
+
+            addAsyncLog(logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction, std::move(message), asyncWrite);
+            return WriteAwaiter{ asyncWrite };
         }
+#endif
 
-        Logger& lineHeader(const std::string& s)
+        Stream stream(
+            const std::string&  logFileName,
+            const Level         logLevel,
+            const char* const   sourceFilePath,
+            const int           sourceLine,
+            const char* const   sourceFunction)
         {
-            const std::unique_lock<std::mutex> lock{ m_configMutex };
-            m_lineHeader = s;
-            return *this;
+            return Stream{ (shouldLog(logLevel, logFileName, sourceFilePath) ? this : nullptr),
+                logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction };
         }
 
-        Logger& functionHeader(const std::string& s)
+        Stream stream(
+            CallSite&           callSite,
+            const std::string&  logFileName,
+            const Level         logLevel,
+            const char* const   sourceFilePath,
+            const int           sourceLine,
+            const char* const   sourceFunction)
         {
-            const std::unique_lock<std::mutex> lock{ m_configMutex };
-            m_functionHeader = s;
-            return *this;
+            return Stream{ (shouldLog(callSite, logLevel, logFileName, sourceFilePath) ? this : nullptr),
+                logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction };
         }
 
-        Logger& messageHeader(const std::string& s)
+    private:
+        static constexpr std::size_t maxFileIDs{ 1024 };    // Call sites logging to more files resolve the level each time
+
+        // Unique across loggers, so a call site's cache from one logger is never taken as valid by another
+        static std::uint64_t nextLevelEpoch()
         {
-            const std::unique_lock<std::mutex> lock{ m_configMutex };
-            m_messageHeader = s;
-            return *this;
+            static std::atomic<std::uint64_t> epoch{ 0 };
+            return ++epoch;
         }
 
-        Logger& metaDataColumns(const std::vector<MetaDataColumn>& v)
+        // Interns the log file's name, maxFileIDs if there's no room left
+        std::size_t fileID(const std::string& logFileName) const
         {
             const std::unique_lock<std::mutex> lock{ m_configMutex };
-            m_metaDataColumns = v;
-            return *this;
+
+            auto it{ m_fileIDs.find(logFileName) };
+            if (it == m_fileIDs.end())
+            {
+                if (maxFileIDs <= m_fileIDs.size())
+                {
+                    return maxFileIDs;
+                }
+
+                it = m_fileIDs.emplace(logFileName, m_fileIDs.size()).first;
+                m_fileIDNames[it->second].store(&it->first, std::memory_order_release);
+            }
+
+            return it->second;
         }
 
-        template<typename ...Ts>
-        Logger& metaDataColumns(const Ts... ts)
+        // Writer whose entry for the file holds the writer its logs go to
+        std::size_t homeWriterIndex(const std::string& logFileName) const
         {
-            return metaDataColumns({ ts... });
+            return ((m_writers.size() == 1) ? 0 : (std::hash<std::string>{}(logFileName) % m_writers.size()));
         }
 
-        bool shouldLog(const Level logLevel) const
+        // Matches '*' to any characters and '?' to one character
+        static bool matchesPattern(const std::string& pattern, const std::string& text)
         {
-            return (isLogging() && logLevel <= level());
+            std::size_t p{ 0 };
+            std::size_t t{ 0 };
+            auto starP{ std::string::npos };
+            std::size_t starT{ 0 };
+
+            while (t < text.size())
+            {
+                if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t]))
+                {
+                    ++p;
+                    ++t;
+                }
+                else if (p < pattern.size() && pattern[p] == '*')
+                {
+                    starP = p++;
+                    starT = t;
+                }
+                else if (starP != std::string::npos)
+                {
+                    // Let the last '*' match one more character
+                    p = starP + 1;
+                    t = ++starT;
+                }
+                else
+                {
+                    return false;
+                }
+            }
+
+            while (p < pattern.size() && pattern[p] == '*')
+            {
+                ++p;
+            }
+
+            return (p == pattern.size());
         }
 
-        void writef(
+        void writeFormatted(
             const std::string&  logFileName,
             const Level         logLevel,
             const char* const   sourceFilePath,
             const int           sourceLine,
             const char* const   sourceFunction,
             const char* const   format,
-            ...)
+            va_list             args)
         {
-            if (shouldLog(logLevel))
+            // Formatted in place and swapped with the log's recycled string, so once
+            // this thread's strings have grown to fit its messages formatting doesn't allocate
+            thread_local std::string message{};
+            int length{ -1 };
+
+            va_list retryArgs;
+            va_copy(retryArgs, args);
+
+            try
             {
-                // Message character limit is 8192
-                va_list args;
-                va_start(args, format);
-                char buffer[8192]{};
+                // Try formatting into the capacity the string already has
+                message.resize(message.capacity());
+                length = vsnprintf(&message[0], (message.size() + 1), format, args);
 
-                try
+                // Too long, grow to the length it needs and format again
+                if (0 <= length && message.size() < static_cast<std::size_t>(length))
                 {
-                    // Create message from format and args
-                    if (vsnprintf(buffer, (sizeof(buffer) / sizeof(buffer[0])), format, args) < 0)
-                    {
-                        buffer[0] = '\0';
-                    }
+                    message.resize(static_cast<std::size_t>(length));
+                    length = vsnprintf(&message[0], (message.size() + 1), format, retryArgs);
                 }
-                catch (...) { buffer[0] = '\0'; }
 
-                va_end(args);
+                if (0 <= length)
+                {
+                    message.resize(static_cast<std::size_t>(length));
+                }
+            }
+            catch (...) { length = -1; }
 
-                // Write message, or use format if message creation failed
-                addLogToBuffer(
-                    logFileName,
-                    logLevel,
-                    sourceFilePath,
-                    sourceLine,
-                    sourceFunction,
-                    (buffer[0] == '\0') ? format : buffer);
+            va_end(retryArgs);
+
+            // Write message, or use format if message creation failed
+            if (length <= 0)
+            {
+                addLogToBuffer(logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction, format);
+            }
+            else
+            {
+                addLogToBuffer(logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction, SwapMessage{ message });
             }
         }
 
-        void write(
-            const std::string&  logFileName,
-            const Level         logLevel,
-            const char* const   sourceFilePath,
-            const int           sourceLine,
-            const char* const   sourceFunction,
-            const std::string&  message)
+        void addAsyncLog(
+            const std::string&                  logFileName,
+            const Level                         logLevel,
+            const char* const                   sourceFilePath,
+            const int                           sourceLine,
+            const char* const                   sourceFunction,
+            std::string&&                       message,
+            const std::shared_ptr<AsyncWrite>&  asyncWrite)
         {
-            if (shouldLog(logLevel))
+            if (shouldLog(logLevel, logFileName, sourceFilePath))
             {
-                addLogToBuffer(logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction, message);
+                addLogToBuffer(logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction, std::move(message), asyncWrite);
+            }
+            else
+            {
+                asyncWrite->complete(false);
             }
         }
 
-        Stream stream(
-            const std::string&  logFileName,
-            const Level         logLevel,
-            const char* const   sourceFilePath,
-            const int           sourceLine,
-            const char* const   sourceFunction)
+        template<class MessageT>
+        void addLogToBuffer(
+            const std::string&                  logFileName,
+            const Level                         logLevel,
+            const char* const                   sourceFilePath,
+            const int                           sourceLine,
+            const char* const                   sourceFunction,
+            MessageT&&                          message,
+            const std::shared_ptr<AsyncWrite>&  asyncWrite = nullptr)
         {
-            return Stream{ this, logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction };
+            addLogToBuffer(Clock::now(), logFileName, logLevel, sourceFilePath, sourceLine, sourceFunction,
+                std::forward<MessageT>(message), asyncWrite);
         }
 
-    private:
+        template<class MessageT>
         void addLogToBuffer(
-            const std::string&  logFileName,
-            const Level         logLevel,
-            const char* const   sourceFilePath,
-            const int           sourceLine,
-            const char* const   sourceFunction,
-            const std::string&  message)
+            const Clock::time_point             timestamp,
+            const std::string&                  logFileName,
+            const Level                         logLevel,
+            const char* const                   sourceFilePath,
+            const int                           sourceLine,
+            const char* const                   sourceFunction,
+            MessageT&&                          message,
+            const std::shared_ptr<AsyncWrite>&  asyncWrite = nullptr)
         {
-            const auto timestamp{ getLocalTimestamp(timestampFormat().c_str()) };
+            const auto threadID{ Logger::threadID() };
 
-            const auto threadID{ std::this_thread::get_id() };
+            auto writerIndex{ homeWriterIndex(logFileName) };
+            auto* writerPtr { m_writers[writerIndex].get() };
 
-            std::unique_lock<std::mutex> lock{ m_loggingMutex };
+            std::unique_lock<std::mutex> lock{ writerPtr->mutex };
+
+            auto it{ writerPtr->logFiles.find(logFileName) };
+            if (it == writerPtr->logFiles.end())
+            {
+                // The file's writer is resolved once, later logs only lock its home writer
+                it = writerPtr->logFiles.emplace(logFileName, LogFile{ this->writerIndex(logFileName) }).first;
+            }
 
-            auto it{ m_logFiles.find(logFileName) };
-            if (it == m_logFiles.end())
+            if (it->second.writerIndex != writerIndex)
             {
-                it = m_logFiles.emplace(logFileName, LogFile{}).first;
+                writerIndex = it->second.writerIndex;
+                writerPtr = m_writers[writerIndex].get();
+                lock = std::unique_lock<std::mutex>{ writerPtr->mutex };
+
+                it = writerPtr->logFiles.find(logFileName);
+                if (it == writerPtr->logFiles.end())
+                {
+                    it = writerPtr->logFiles.emplace(logFileName, LogFile{ writerIndex }).first;
+                }
             }
 
+            auto& writer{ *writerPtr };
+
             auto& buffer        { it->second.buffer };
+            auto& recycled      { it->second.recycled };
             auto bufferMaxSize  { this->bufferMaxSize() };
 
             if (bufferMaxSize == 0 || buffer.size() < bufferMaxSize)
             {
-                buffer.emplace_back(
-                    timestamp,
-                    threadID,
-                    logLevel,
-                    sourceFilePath,
-                    sourceLine,
-                    sourceFunction,
-                    message);
+                if (recycled.empty())
+                {
+                    buffer.emplace_back(
+                        timestamp,
+                        threadID,
+                        logLevel,
+                        sourceFilePath,
+                        sourceLine,
+                        sourceFunction,
+                        std::forward<MessageT>(message));
+                }
+                else
+                {
+                    // Splicing doesn't touch the logs the writer thread is working on
+                    buffer.splice(buffer.end(), recycled, recycled.begin());
+                    buffer.back().reuse(
+                        timestamp,
+                        threadID,
+                        logLevel,
+                        sourceFilePath,
+                        sourceLine,
+                        sourceFunction,
+                        std::forward<MessageT>(message));
+                }
+
+                if (asyncWrite)
+                {
+                    buffer.back().asyncWrite = asyncWrite;
+                    ++(it->second.numAsyncWrites);
+                }
 
-                if (bufferFlushSize() <= buffer.size())
+                if (asyncWrite || bufferFlushSize() <= buffer.size())
                 {
-                    // Unlock the mutex and wake the logging thread
+                    // Unlock the mutex and wake the writer thread
                     lock.unlock();
-                    m_loggingThreadCondition.notify_one();
+                    writer.condition.notify_one();
                 }
             }
             else
             {
                 // Queue is full, discard log
                 ++m_numDiscardedLogs;
+
+                if (asyncWrite)
+                {
+                    lock.unlock();
+                    asyncWrite->complete(false);
+                }
             }
         }
 
@@ -864,6 +3033,9 @@ namespace pluto
                 }
 
                 pluto::FileSystem::remove(thisPath);
+
+                std::error_code error{};
+                pluto::FileSystem::remove(getIndexFilePath(thisPath), error);
             }
 
             for (auto i{ numFiles }; 0 < i; )
@@ -877,10 +3049,129 @@ namespace pluto
                 const auto oldPath{ parentPath / (oldStem + extension) };
 
                 pluto::FileSystem::rename(oldPath, newPath);
+
+                // The index goes with its file, if there is one
+                std::error_code error{};
+                pluto::FileSystem::remove(getIndexFilePath(newPath), error);
+                pluto::FileSystem::rename(getIndexFilePath(oldPath), getIndexFilePath(newPath), error);
+            }
+        }
+
+        // Files from earlier periods are done with once a new one starts, so retention is applied then
+        pluto::FileSystem::path startRotationPeriod(
+            const pluto::FileSystem::path&  basePath,
+            const FileRotationPeriod        period,
+            const Clock::time_point         timestamp,
+            Clock::time_point&              nextRotationTime) const
+        {
+            const auto filePath{ getPeriodFilePath(basePath, period, timestamp, nextRotationTime) };
+            removeExpiredFiles(basePath, filePath);
+            return filePath;
+        }
+
+        // Rotated files are named stem[.period][_number]extension
+        static bool isRotatedFile(const std::string& fileName, const std::string& stem, const std::string& extension)
+        {
+            if (fileName.size() <= (stem.size() + extension.size()) ||
+                fileName.compare(0, stem.size(), stem) != 0 ||
+                fileName.compare(fileName.size() - extension.size(), extension.size(), extension) != 0)
+            {
+                return false;
+            }
+
+            const auto isDigit{ [](const char c) { return ('0' <= c && c <= '9'); } };
+            const auto end{ fileName.size() - extension.size() };
+            auto i{ stem.size() };
+
+            if (fileName[i] == '.')
+            {
+                const auto start{ ++i };
+                for (; i < end && (isDigit(fileName[i]) || fileName[i] == '-' || fileName[i] == 'T'); ++i);
+
+                if (i == start)
+                {
+                    return false;
+                }
+            }
+
+            if (i < end && fileName[i] == '_')
+            {
+                const auto start{ ++i };
+                for (; i < end && isDigit(fileName[i]); ++i);
+
+                if (i == start)
+                {
+                    return false;
+                }
+            }
+
+            return (i == end);
+        }
+
+        // Removes rotated files older than the retention age, then the oldest until the rest fit the retention size.
+        // Best effort, a file that can't be removed doesn't stop logging.
+        void removeExpiredFiles(const pluto::FileSystem::path& basePath, const pluto::FileSystem::path& activePath) const
+        {
+            typedef pluto::FileSystem::file_time_type FileTime;
+
+            const auto fileRetentionAge { this->fileRetentionAge() };
+            const auto fileRetentionSize{ this->fileRetentionSize() };
+
+            if (fileRetentionAge == 0 && fileRetentionSize == 0)
+            {
+                return;
+            }
+
+            try
+            {
+                const auto stem         { basePath.stem().string() };
+                const auto extension    { basePath.extension().string() };
+                const auto activeName   { activePath.filename().string() };
+
+                struct RotatedFile
+                {
+                    FileTime                    time;
+                    std::size_t                 size;
+                    pluto::FileSystem::path     path;
+                };
+
+                std::vector<RotatedFile> files{};
+                std::size_t totalSize{ 0 };
+
+                for (const auto& entry : pluto::FileSystem::directory_iterator{ basePath.parent_path() })
+                {
+                    const auto fileName{ entry.path().filename().string() };
+                    if (fileName != activeName && isRotatedFile(fileName, stem, extension))
+                    {
+                        const auto size{ static_cast<std::size_t>(pluto::FileSystem::file_size(entry.path())) };
+                        files.push_back({ pluto::FileSystem::last_write_time(entry.path()), size, entry.path() });
+                        totalSize += size;
+                    }
+                }
+
+                std::sort(files.begin(), files.end(),
+                    [](const RotatedFile& lhs, const RotatedFile& rhs) { return (lhs.time < rhs.time); });
+
+                const auto oldestTime{ FileTime::clock::now() - std::chrono::seconds(fileRetentionAge) };
+
+                for (const auto& file : files)
+                {
+                    if ((fileRetentionAge != 0 && file.time < oldestTime) ||
+                        (fileRetentionSize != 0 && fileRetentionSize < totalSize))
+                    {
+                        std::error_code error{};
+                        if (pluto::FileSystem::remove(file.path, error))
+                        {
+                            totalSize -= file.size;
+                            pluto::FileSystem::remove(getIndexFilePath(file.path), error);
+                        }
+                    }
+                }
             }
+            catch (...) {}
         }
 
-        void openFileStream(std::ofstream& fileStream, const pluto::FileSystem::path& filePath) const
+        static void openFileStream(std::ofstream& fileStream, const pluto::FileSystem::path& filePath)
         {
             fileStream.open(filePath, (std::ios_base::ate | std::ios_base::app));
 
@@ -977,110 +3268,334 @@ namespace pluto
             }
         }
 
-        void writeLogToStream(std::ostream& stream, const Log& log) const
+        static ThreadNames& getThreadNames()
         {
-            const std::unique_lock<std::mutex> lock{ m_configMutex };
+            static ThreadNames threadNames{};
+            return threadNames;
+        }
 
-            stream << std::left << std::setfill(' ');
+        const std::string& getThreadIDColumn(ThreadIDColumns& columns, const std::size_t id) const
+        {
+            const auto version{ getThreadNames().version.load() };
+            const auto length{ threadIDLength() };
 
-            for (const auto metaDataColumn : m_metaDataColumns)
+            if (columns.version != version || columns.length != length || columns.slots.empty())
+            {
+                columns.slots.assign(ThreadIDColumns::numSlots, ThreadIDColumns::Slot{ 0, {} });
+                columns.version = version;
+                columns.length = length;
+            }
+
+            auto& slot{ columns.slots[id % ThreadIDColumns::numSlots] };
+            auto& text{ slot.text };
+
+            if (slot.id != id)
+            {
+                slot.id = id;
+                text = threadName(id);
+
+                if (text.size() < length)
+                {
+                    text.append(length - text.size(), ' ');
+                }
+            }
+
+            return text;
+        }
+
+        // Requires m_configMutex to be locked
+        void getRenderSettings(RenderSettings& settings) const
+        {
+            settings.metaDataColumns    = m_metaDataColumns;
+            settings.separator          = m_separator;
+            settings.timestampFormat    = m_timestampFormat;
+            settings.processIDColumn    = std::to_string(m_processID);
+            settings.levelFormat        = levelFormat();
+            settings.timestampLength    = timestampLength();
+            settings.fileNameLength     = fileNameLength();
+
+            if (settings.processIDColumn.size() < processIDLength())
+            {
+                settings.processIDColumn.append(processIDLength() - settings.processIDColumn.size(), ' ');
+            }
+            settings.lineLength         = lineLength();
+            settings.functionLength     = functionLength();
+        }
+
+        // Pads with spaces to length, longer columns are kept whole
+        static void appendColumn(std::string& text, const char* const column, const std::size_t size, const std::size_t length)
+        {
+            text.append(column, size);
+
+            if (size < length)
+            {
+                text.append(length - size, ' ');
+            }
+        }
+
+        // Like getFileName, without building a path
+        static const char* findFileName(const char* const filePath)
+        {
+            auto fileName{ filePath };
+
+            for (auto c{ filePath }; *c != '\0'; ++c)
+            {
+#ifdef _WIN32
+                if (*c == '/' || *c == '\\')
+#else
+                if (*c == '/')
+#endif
+                {
+                    fileName = (c + 1);
+                }
+            }
+
+            return fileName;
+        }
+
+        static void appendTimestamp(
+            std::string&            text,
+            TimestampColumn&        column,
+            const std::string&      format,
+            const Clock::time_point timestamp)
+        {
+            const auto posixTime{ Clock::to_time_t(timestamp) };
+
+            if (column.second != posixTime || column.format != format)
+            {
+                column.second = posixTime;
+                column.format = format;
+                column.text.clear();
+                column.fractions.clear();
+
+                std::tm localTime{};
+#ifdef _WIN32
+                if (localtime_s(&localTime, &posixTime) == 0)
+#else
+                if (localtime_r(&posixTime, &localTime) != nullptr)
+#endif
+                {
+                    // Format the parts between fractions separately, leaving zeros for each fraction
+                    std::ostringstream stream{};
+                    std::size_t partBegin{ 0 };
+
+                    for (std::size_t i{ 0 }; (i + 3) < format.size(); ++i)
+                    {
+                        const auto precision{ static_cast<std::size_t>(format[i + 2] - '0') };
+
+                        if (format[i] == '%' && format[i + 1] == '.' && format[i + 3] == 'S' && 0 < precision && precision < 10)
+                        {
+                            stream << std::put_time(&localTime, format.substr(partBegin, i - partBegin).c_str());
+                            column.fractions.emplace_back(static_cast<std::size_t>(stream.tellp()), precision);
+                            stream << std::string(precision, '0');
+
+                            i += 3;
+                            partBegin = (i + 1);
+                        }
+                    }
+
+                    stream << std::put_time(&localTime, format.substr(partBegin).c_str());
+                    column.text = stream.str();
+                }
+            }
+
+            const auto offset{ text.size() };
+            text += column.text;
+
+            if (!column.fractions.empty())
+            {
+                auto nanoseconds{ std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    timestamp.time_since_epoch()).count() % 1'000'000'000 };
+
+                if (nanoseconds < 0)
+                {
+                    nanoseconds += 1'000'000'000;
+                }
+
+                char digits[9]{};
+                for (auto i{ sizeof(digits) }; i != 0; --i)
+                {
+                    digits[i - 1] = static_cast<char>('0' + (nanoseconds % 10));
+                    nanoseconds /= 10;
+                }
+
+                for (const auto& fraction : column.fractions)
+                {
+                    text.replace(offset + fraction.first, fraction.second, digits, fraction.second);
+                }
+            }
+        }
+
+        // Appends the rendered log to text, which keeps its capacity from log to log
+        void renderLog(
+            std::string&            text,
+            const Log&              log,
+            const RenderSettings&   settings,
+            ThreadIDColumns&        threadIDColumns,
+            TimestampColumn&        timestampColumn) const
+        {
+            const auto& separator{ settings.separator };
+
+            for (const auto metaDataColumn : settings.metaDataColumns)
             {
                 switch (metaDataColumn)
                 {
                     case MetaDataColumn::Timestamp:
-                        stream << std::setw(timestampLength()) << log.timestamp << m_separator;
+                    {
+                        const auto offset{ text.size() };
+                        appendTimestamp(text, timestampColumn, settings.timestampFormat, log.timestamp);
+
+                        if ((text.size() - offset) < settings.timestampLength)
+                        {
+                            text.append(settings.timestampLength - (text.size() - offset), ' ');
+                        }
+
                         break;
+                    }
 
                     case MetaDataColumn::ProcessID:
-                        stream << std::setw(processIDLength()) << m_processID << m_separator;
+                        text += settings.processIDColumn;
                         break;
 
                     case MetaDataColumn::ThreadID:
-                        stream << std::setw(threadIDLength()) << log.threadID << m_separator;
+                        text += getThreadIDColumn(threadIDColumns, log.threadID);
                         break;
 
                     case MetaDataColumn::Level:
-                        stream << levelToString(log.level, levelFormat()) << m_separator;
+                        text += levelToString(log.level, settings.levelFormat);
                         break;
 
                     case MetaDataColumn::FileName:
                     {
-                        const auto fileNameLength{ this->fileNameLength() };
-
-                        stream << std::setw(fileNameLength)
-                            << std::string(getFileName(log.sourceFilePath), 0, fileNameLength) << m_separator;
+                        const auto fileName{ findFileName(log.sourceFilePath) };
+                        appendColumn(text, fileName, std::min(std::strlen(fileName), settings.fileNameLength), settings.fileNameLength);
                         break;
                     }
 
                     case MetaDataColumn::Line:
-                        stream << std::setw(lineLength()) << log.sourceLine << m_separator;
+                    {
+                        char line[16]{};
+                        const auto size{ std::snprintf(line, sizeof(line), "%d", log.sourceLine) };
+                        appendColumn(text, line, static_cast<std::size_t>(std::max(size, 0)), settings.lineLength);
                         break;
+                    }
 
                     case MetaDataColumn::Function:
-                    {
-                        const auto functionLength{ this->functionLength() };
-
-                        stream << std::setw(functionLength)
-                            << std::string(log.sourceFunction, 0, functionLength) << m_separator;
+                        appendColumn(text, log.sourceFunction,
+                            std::min(std::strlen(log.sourceFunction), settings.functionLength), settings.functionLength);
                         break;
-                    }
                 }
+
+                text += separator;
+            }
+
+            text += log.message;
+            text += '\n';
+        }
+
+        // Requires m_configMutex to be locked. Logs written directly and
+        // through routes to the same file share one sink so their writes are serialized.
+        std::shared_ptr<Sink> getFileSink(const std::string& fileName)
+        {
+            auto& sink{ m_fileSinks[fileName] };
+            if (!sink)
+            {
+#ifndef _WIN32
+                // Files keep the mode they were opened with
+                if (fileMapSize() != 0)
+                {
+                    sink = std::make_shared<MappedFileSink>(m_lifetime, fileName);
+                }
+                else
+#endif
+                {
+                    sink = std::make_shared<FileSink>(m_lifetime, fileName);
+                }
+            }
+
+            return sink;
+        }
+
+        static bool writeToSink(Sink& sink, const LogBatch& logs, const bool shouldSync = false)
+        {
+            try
+            {
+                const std::unique_lock<std::mutex> lock{ sink.m_mutex };
+                sink.m_shouldSync = shouldSync;
+                return sink.write(logs);
             }
+            catch (...) {}
 
-            stream << log.message << '\n';
+            return false;
         }
 
-        bool writeBufferToFile(
+        bool writeBuffer(
+            Writer&                     writer,
             const LogBuffer::iterator   begin,
             const LogBuffer::iterator   secondToEnd,
-            const std::string&          fileName,
-            pluto::FileSystem::path&    filePath,
-            bool&                       dirsCreated) const
+            const std::string&          fileName)
         {
-            auto result{ true };
+            std::shared_ptr<Sink> sink{};
+            std::vector<Route> routes{};
+            LogBatch logs{};
+            bool hasAsyncWrites{ false };
+            bool shouldSync{ false };
 
-            try
             {
-                // Get file path if empty
-                if (filePath.empty())
+                // Gone if this writer was abandoned at the shutdown timeout
+                const Lifetime::Use use{ *writer.lifetime };
+                if (!use)
                 {
-                    filePath = pluto::FileSystem::absolute(fileName);
+                    return false;
                 }
 
-                // Create path to file if needed
-                if (createDirs() && !dirsCreated)
                 {
-                    pluto::FileSystem::create_directories(filePath.parent_path());
-                    dirsCreated = true;
-                }
+                    const std::unique_lock<std::mutex> lock{ m_configMutex };
 
-                const auto writeHeader{ this->writeHeader() };
-                const auto fileRotationSize{ this->fileRotationSize() };
+                    sink = getFileSink(fileName);
+                    getRenderSettings(writer.renderSettings);
 
-                std::size_t fileSize{ 0 };
-                std::ofstream fileStream{};
-                openFileStream(fileStream, filePath);
+                    const auto it{ m_routes.find(fileName) };
+                    if (it != m_routes.end())
+                    {
+                        routes = it->second;
+                    }
+                }
 
+                // Render each log once, every sink writes the same text
                 for (auto it{ begin }; ; ++it)
                 {
-                    fileSize = static_cast<std::size_t>(fileStream.tellp());
+                    it->rendered.clear();
+                    renderLog(it->rendered, *it, writer.renderSettings, writer.threadIDColumns, writer.timestampColumn);
+                    logs.push_back(&(*it));
 
-                    // Rotate file if needed
-                    if (fileRotationSize != 0 && fileRotationSize <= fileSize)
+                    if (it->asyncWrite)
                     {
-                        fileStream.close();
-                        rotateFile(filePath);
-                        openFileStream(fileStream, filePath);
-                        fileSize = static_cast<std::size_t>(fileStream.tellp());
+                        hasAsyncWrites = true;
+                        shouldSync = (shouldSync || it->asyncWrite->sync());
                     }
 
-                    // Write header if needed
-                    if (writeHeader && fileSize == 0)
+                    if (it == secondToEnd)
                     {
-                        writeHeaderToStream(fileStream);
+                        break;
                     }
+                }
+            }
+
+            if (!writeToSink(*sink, logs, shouldSync))
+            {
+                return false;
+            }
 
-                    writeLogToStream(fileStream, *it);
+            // Complete the batch's waiters together once it's in the file, routes don't hold them up
+            if (hasAsyncWrites)
+            {
+                for (auto it{ begin }; ; ++it)
+                {
+                    if (it->asyncWrite)
+                    {
+                        it->asyncWrite->complete(true);
+                    }
 
                     if (it == secondToEnd)
                     {
@@ -1088,41 +3603,229 @@ namespace pluto
                     }
                 }
             }
-            catch (const pluto::FileSystem::filesystem_error&)
+
+            // A writer left blocked in the sink past the shutdown timeout stops here
+            if (!routes.empty() && writer.lifetime->hasEnded())
             {
-                result = false;
+                return true;
             }
 
-            return result;
+            // Routes are best effort, a failed route doesn't hold back the file
+            LogBatch routeLogs{};
+            for (const auto& route : routes)
+            {
+                routeLogs.clear();
+
+                for (const auto log : logs)
+                {
+                    if (log->level <= route.level)
+                    {
+                        routeLogs.push_back(log);
+                    }
+                }
+
+                if (!routeLogs.empty())
+                {
+                    writeToSink(*route.sink, routeLogs);
+                }
+            }
+
+            return true;
+        }
+
+        void notifyWriters()
+        {
+            for (auto& writer : m_writers)
+            {
+                writer->condition.notify_one();
+            }
+        }
+
+        // Called on the writer thread. Only settings that were set are applied.
+        void applyWriterSettings()
+        {
+#ifdef __linux__
+            std::vector<std::size_t> cpus{};
+            auto isAffinitySet{ false };
+
+            {
+                const std::unique_lock<std::mutex> lock{ m_configMutex };
+                cpus = m_writerAffinity;
+                isAffinitySet = m_isWriterAffinitySet;
+            }
+
+            if (isAffinitySet)
+            {
+                cpu_set_t cpuSet{};
+                CPU_ZERO(&cpuSet);
+
+                for (std::size_t cpu{ 0 }; cpu < CPU_SETSIZE; ++cpu)
+                {
+                    if (cpus.empty() || std::find(cpus.begin(), cpus.end(), cpu) != cpus.end())
+                    {
+                        CPU_SET(cpu, &cpuSet);
+                    }
+                }
+
+                // Best effort, CPUs that don't exist or aren't allowed leave the affinity as it was
+                static_cast<void>(::pthread_setaffinity_np(::pthread_self(), sizeof(cpuSet), &cpuSet));
+            }
+
+            if (m_isWriterPrioritySet.load())
+            {
+                static_cast<void>(::setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), writerPriority()));
+            }
+#endif
+        }
+
+        // Last log of the next batch, taking at most maxBatchSize logs when it isn't 0
+        static LogBuffer::iterator getBatchEnd(LogBuffer& buffer, const std::size_t maxBatchSize, std::size_t& numLogs)
+        {
+            if (maxBatchSize == 0 || buffer.size() <= maxBatchSize)
+            {
+                numLogs = buffer.size();
+                return --(buffer.end());
+            }
+
+            numLogs = maxBatchSize;
+            return std::next(buffer.begin(), static_cast<std::ptrdiff_t>(maxBatchSize - 1));
+        }
+
+        std::size_t numUnwrittenLogs() const
+        {
+            std::size_t numLogs{ 0 };
+
+            for (const auto& writer : m_writers)
+            {
+                const std::unique_lock<std::mutex> lock{ writer->mutex };
+
+                for (const auto& logFilePair : writer->logFiles)
+                {
+                    numLogs += logFilePair.second.buffer.size();
+                }
+            }
+
+            return numLogs;
+        }
+
+        bool spillLogs(const std::string& spillFile, const std::vector<std::pair<std::string, LogBuffer>>& unwrittenLogs)
+        {
+            try
+            {
+                std::ofstream fileStream{ spillFile, std::ios::app };
+                if (!fileStream.is_open() || !fileStream.good())
+                {
+                    return false;
+                }
+
+                RenderSettings settings{};
+                ThreadIDColumns threadIDColumns{};
+                TimestampColumn timestampColumn{};
+                std::string text{};
+
+                {
+                    const std::unique_lock<std::mutex> lock{ m_configMutex };
+                    getRenderSettings(settings);
+                }
+
+                for (const auto& logsPair : unwrittenLogs)
+                {
+                    for (const auto& log : logsPair.second)
+                    {
+                        text = logsPair.first;
+                        text += settings.separator;
+                        renderLog(text, log, settings, threadIDColumns, timestampColumn);
+                        fileStream << text;
+                    }
+                }
+
+                fileStream.flush();
+                return fileStream.good();
+            }
+            catch (...) {}
+
+            return false;
         }
 
-        void startLogging()
+        void startLogging(const std::shared_ptr<Writer> writerPtr)
         {
+            typedef std::chrono::steady_clock SteadyClock;
+
+            auto& writer{ *writerPtr };
             bool shouldWait{ false };
-            std::unique_lock<std::mutex> lock{ m_loggingMutex };
+            auto lastRoundTime{ SteadyClock::now() };
+            auto retryTime{ SteadyClock::time_point::max() };
+            std::unique_lock<std::mutex> lock{ writer.mutex };
 
-            while (m_isLogging.load())
+            // An abandoned writer returns as soon as it sees it, the logger may be gone
+            while (!writer.isAbandoned && m_isLogging.load())
             {
+                const auto settingsVersion{ m_writerSettingsVersion.load() };
+                if (writer.settingsVersion != settingsVersion)
+                {
+                    // Rare, so applied without unlocking
+                    writer.settingsVersion = settingsVersion;
+                    applyWriterSettings();
+                }
+
                 if (shouldWait)
                 {
-                    m_loggingThreadCondition.wait(lock);
+                    // Files backing off from a failed write are retried without a notification
+                    if (retryTime == SteadyClock::time_point::max())
+                    {
+                        writer.condition.wait(lock);
+                    }
+                    else
+                    {
+                        writer.condition.wait_until(lock, retryTime);
+                    }
+
                     shouldWait = false;
                 }
                 else
                 {
+                    // Sleep off the rest of the wake delay unlocked, so producers aren't held up
+                    // and their notifications don't wake this thread early
+                    const auto nextRoundTime{ lastRoundTime + std::chrono::microseconds(writerWakeDelay()) };
+                    if (SteadyClock::now() < nextRoundTime)
+                    {
+                        lock.unlock();
+                        std::this_thread::sleep_until(nextRoundTime);
+                        lock.lock();
+
+                        if (writer.isAbandoned)
+                        {
+                            return;
+                        }
+                    }
+
+                    lastRoundTime = SteadyClock::now();
+                    retryTime = SteadyClock::time_point::max();
                     shouldWait = true;
 
-                    for (auto& logFilePair : m_logFiles)
+                    const auto bufferMaxBatchSize{ this->bufferMaxBatchSize() };
+
+                    for (auto& logFilePair : writer.logFiles)
                     {
-                        auto& fileName      { logFilePair.first };
-                        auto& buffer        { logFilePair.second.buffer };
-                        auto& filePath      { logFilePair.second.filePath };
-                        auto& dirsCreated   { logFilePair.second.dirsCreated };
+                        auto& fileName  { logFilePair.first };
+                        auto& buffer    { logFilePair.second.buffer };
+
+                        auto& logFile   { logFilePair.second };
+
+                        if (logFile.numFailedWrites != 0 && lastRoundTime < logFile.retryTime)
+                        {
+                            retryTime = std::min(retryTime, logFile.retryTime);
+                            continue;
+                        }
 
-                        if (!buffer.empty() && bufferFlushSize() <= buffer.size())
+                        if (!buffer.empty() && (bufferFlushSize() <= buffer.size() || logFile.numAsyncWrites != 0))
                         {
+                            std::size_t numLogs{ 0 };
                             const auto begin        { buffer.begin() };
-                            const auto secondToEnd  { --(buffer.end()) };
+                            const auto secondToEnd  { getBatchEnd(buffer, bufferMaxBatchSize, numLogs) };
+
+                            writer.writingFileName = &fileName;
+                            writer.numWriting = numLogs;
 
                             // Doesn't require synchronization.
                             // Since this thread stays within the range gotten when locked
@@ -1132,20 +3835,122 @@ namespace pluto
                             // Since other threads can add logs, don't wait when done.
                             shouldWait = false;
 
-                            const auto result{ writeBufferToFile(
-                                begin, secondToEnd, fileName, filePath, dirsCreated) };
+                            const auto result{ writeBuffer(writer, begin, secondToEnd, fileName) };
 
                             lock.lock();
+                            writer.numWriting = 0;
+
+                            if (writer.isAbandoned)
+                            {
+                                return;
+                            }
+
+                            if (!result)
+                            {
+                                // Back off from a failing sink, doubling the wait up to a second
+                                const auto backoff{ std::min(std::size_t{ 1000 },
+                                    (std::size_t{ 1 } << std::min(logFile.numFailedWrites, std::size_t{ 10 }))) };
+
+                                ++logFile.numFailedWrites;
+                                logFile.retryTime = SteadyClock::now() + std::chrono::milliseconds(backoff);
+                            }
 
-                            // Erase the logs after re-locking.
+                            // Recycle the logs after re-locking.
                             if (result)
                             {
-                                buffer.erase(begin, std::next(secondToEnd));
+                                logFile.numFailedWrites = 0;
+
+                                if (logFile.numAsyncWrites != 0)
+                                {
+                                    for (auto it{ begin }; ; ++it)
+                                    {
+                                        if (it->asyncWrite)
+                                        {
+                                            it->asyncWrite.reset();
+                                            --logFile.numAsyncWrites;
+                                        }
+
+                                        if (it == secondToEnd)
+                                        {
+                                            break;
+                                        }
+                                    }
+                                }
+
+                                // Strings grown by a burst of large logs aren't kept
+                                const auto bufferRecycleCapacity{ this->bufferRecycleCapacity() };
+                                for (auto it{ begin }; ; ++it)
+                                {
+                                    if (bufferRecycleCapacity < it->message.capacity())
+                                    {
+                                        std::string{}.swap(it->message);
+                                    }
+
+                                    if (bufferRecycleCapacity < it->rendered.capacity())
+                                    {
+                                        std::string{}.swap(it->rendered);
+                                    }
+
+                                    if (it == secondToEnd)
+                                    {
+                                        break;
+                                    }
+                                }
+
+                                auto& recycled{ logFile.recycled };
+                                recycled.splice(recycled.end(), buffer, begin, std::next(secondToEnd));
+
+                                const auto bufferRecycleSize{ this->bufferRecycleSize() };
+                                while (bufferRecycleSize < recycled.size())
+                                {
+                                    recycled.pop_back();
+                                }
                             }
                         }
                     }
                 }
             }
+
+            if (writer.isAbandoned)
+            {
+                return;
+            }
+
+            // Logging stopped, write what's left a batch at a time so the destructor can stop waiting between batches
+            const auto bufferMaxBatchSize{ this->bufferMaxBatchSize() };
+            const auto maxBatchSize{ (bufferMaxBatchSize == 0) ? std::size_t{ 1024 } : bufferMaxBatchSize };
+
+            for (auto& logFilePair : writer.logFiles)
+            {
+                auto& fileName  { logFilePair.first };
+                auto& buffer    { logFilePair.second.buffer };
+
+                while (!buffer.empty())
+                {
+                    std::size_t numLogs{ 0 };
+                    const auto secondToEnd{ getBatchEnd(buffer, maxBatchSize, numLogs) };
+
+                    writer.writingFileName = &fileName;
+                    writer.numWriting = numLogs;
+                    lock.unlock();
+
+                    writeBuffer(writer, buffer.begin(), secondToEnd, fileName);
+
+                    lock.lock();
+                    writer.numWriting = 0;
+
+                    // Failed logs are dropped too, the destructor is waiting
+                    buffer.erase(buffer.begin(), std::next(secondToEnd));
+
+                    if (writer.isAbandoned)
+                    {
+                        return;
+                    }
+                }
+            }
+
+            writer.isDone = true;
+            writer.doneCondition.notify_all();
         }
     };
 }
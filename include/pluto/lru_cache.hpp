@@ -7,124 +7,818 @@
 
 #pragma once
 
-#include <map>
-#include <list>
+#include <new>
+#include <memory>
+#include <cstddef>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+#include "eviction_policies.hpp"
+#include "expiry_policies.hpp"
 
 namespace pluto
 {
-    template<class KeyT, class ValueT>
+    // Weighs every entry as 1, so the capacity is a number of entries
+    struct UnitWeigher
+    {
+        template<class KeyT, class ValueT>
+        constexpr std::size_t operator()(const KeyT&, const ValueT&) const { return 1; }
+    };
+
+    // Evicts the least recently used entry by default, PolicyT can be any policy from eviction_policies.hpp.
+    // Entries never expire by default, ExpiryT can be any policy from expiry_policies.hpp.
+    //
+    // WeigherT is called as weigher(key, value) when an entry is inserted, and the capacity is the
+    // total weight the cache holds, in bytes for example. Only policies that support weights can
+    // have entries weigh more than 1.
+    template<
+        class KeyT,
+        class ValueT,
+        class HashT     = std::hash<KeyT>,
+        class KeyEqualT = std::equal_to<KeyT>,
+        class PolicyT   = LRUPolicy,
+        class ExpiryT   = NoExpiry,
+        class WeigherT  = UnitWeigher>
     class LRUCache
     {
     public:
         typedef KeyT KeyType;
         typedef ValueT ValueType;
-        typedef std::list<KeyType> ListType;
-        typedef std::map<KeyType, std::pair<ValueType, typename ListType::iterator>> MapType;
+        typedef HashT HasherType;
+        typedef KeyEqualT KeyEqualType;
+        typedef PolicyT PolicyType;
+        typedef ExpiryT ExpiryType;
+        typedef WeigherT WeigherType;
+        typedef typename ExpiryType::DurationType DurationType;
+
+        static constexpr bool isUnitWeight() { return std::is_same<WeigherType, UnitWeigher>::value; }
+
+        static_assert(isUnitWeight() || PolicyType::supportsWeights(),
+            "PolicyT sizes itself by the number of entries, it needs entries that weigh 1");
+
+        // True if hits only read the cache or store atomics, so get() can run on several threads at once.
+        // Never with expiry, as hits reclaim expired entries.
+        static constexpr bool concurrentHits() { return (PolicyType::concurrentHits() && !ExpiryType::enabled()); }
 
     private:
-        std::size_t m_capacity;
-        ListType    m_list{};
-        MapType     m_map{};
-    
-    public:
-        LRUCache(const std::size_t capacity) :
-            m_capacity{ capacity } {}
+        typedef typename PolicyType::Hook HookType;
+        typedef typename ExpiryType::Hook TimerType;
+
+        // Entries keep the weight they were inserted with, so the total stays right if a value is
+        // updated in place. Not kept when every entry weighs 1.
+        template<class WeigherU, class = void>
+        struct WeightHook
+        {
+            std::size_t entryWeight;
 
-        ~LRUCache() {}
+            std::size_t weight() const              { return entryWeight; }
+            void weight(const std::size_t weight)   { entryWeight = weight; }
+        };
 
-        std::size_t size()                  const   { return m_map.size(); }
-        std::size_t capacity()              const   { return m_capacity; }
-        bool empty()                        const   { return m_map.empty(); }
-        bool contains(const KeyType& key)   const   { return (m_map.find(key) != m_map.end()); }
+        template<class UnusedT>
+        struct WeightHook<UnitWeigher, UnusedT>
+        {
+            std::size_t weight() const  { return 1; }
+            void weight(const std::size_t) {}
+        };
 
-        void capacity(const std::size_t newCapacity)
+        typedef WeightHook<WeigherType> WeightType;
+
+        // Each entry is one node holding the key once, its value, the link to the next node
+        // in its hash bucket and the eviction and expiry policies' hooks. A policy can keep the
+        // node after its value is evicted, to remember the key was cached.
+        struct Node : HookType, TimerType, WeightType
         {
-            m_capacity = newCapacity;
+            Node*       chainNext;  // Next node in the same bucket
+            KeyType     key;
+
+            union
+            {
+                ValueType value;    // Constructed and destroyed by the cache
+            };
+
+            Node(const std::size_t hash, const KeyType& key, const ValueType& value) :
+                HookType    {},
+                TimerType   {},
+                WeightType  {},
+                chainNext   { nullptr },
+                key         { key },
+                value       { value }
+            {
+                this->hash = hash;
+            }
+
+            ~Node() {}
+        };
+
+        // Nodes are constructed in slots carved from slabs. Free slots are linked through the slot itself.
+        union Slot
+        {
+            Slot*   nextFree;
+            Node    node;
+
+            Slot() : nextFree{ nullptr } {}
+            ~Slot() {}
+        };
+
+        std::size_t                         m_capacity;
+        bool                                m_preallocate;
+        std::size_t                         m_size      { 0 };      // Entries with values
+        std::size_t                         m_weight    { 0 };      // Of the entries with values
+        std::size_t                         m_numNodes  { 0 };      // Including keys the policy remembers
+        std::vector<Node*>                  m_buckets   {};         // Power of two in size, or empty
+        unsigned                            m_shift     { 64 };     // Hashes are mixed and shifted down to a bucket index
+        std::vector<std::unique_ptr<Slot[]>> m_slabs    {};
+        std::size_t                         m_numSlots  { 0 };
+        Slot*                               m_freeSlots { nullptr };
+        PolicyType                          m_policy    {};
+        ExpiryType                          m_expiry    {};
+        HasherType                          m_hasher;
+        KeyEqualType                        m_keyEqual;
+        WeigherType                         m_weigher;
+
+    public:
+        // Preallocating allocates every node and bucket up front, and again when the capacity grows,
+        // including nodes for the keys the policy remembers. Otherwise nodes are allocated in growing
+        // slabs as the cache fills. Either way a full cache reuses the evicted node for the entry
+        // replacing it, so it doesn't allocate in steady state.
+        // Memory for nodes is kept for reuse until the cache is destroyed. With weights the number
+        // of entries isn't known up front, so preallocating is ignored.
+        LRUCache(
+            const std::size_t   capacity,
+            const bool          preallocate = false,
+            const HasherType&   hasher      = HasherType{},
+            const KeyEqualType& keyEqual    = KeyEqualType{},
+            const WeigherType&  weigher     = WeigherType{}) :
+            m_capacity      { capacity },
+            m_preallocate   { preallocate && isUnitWeight() },
+            m_hasher        { hasher },
+            m_keyEqual      { keyEqual },
+            m_weigher       { weigher }
+        {
+            m_policy.capacity(m_capacity);
 
-            // While cache is above capacity, evict the least recently used item
-            while (m_capacity < size())
+            if (m_preallocate)
             {
-                evictLRU();
+                reserve(maxNodes());
             }
         }
 
-        void insert(const KeyType& key, const ValueType& value)
+        LRUCache(const LRUCache& other) :
+            m_capacity      { other.m_capacity },
+            m_preallocate   { other.m_preallocate },
+            m_expiry        { other.m_expiry },
+            m_hasher        { other.m_hasher },
+            m_keyEqual      { other.m_keyEqual },
+            m_weigher       { other.m_weigher }
+        {
+            m_policy.capacity(m_capacity);
+
+            if (m_preallocate)
+            {
+                reserve(maxNodes());
+            }
+
+            copyEntries(other);
+        }
+
+        LRUCache(LRUCache&& other) :
+            m_capacity      { other.m_capacity },
+            m_preallocate   { other.m_preallocate },
+            m_hasher        { other.m_hasher },
+            m_keyEqual      { other.m_keyEqual },
+            m_weigher       { other.m_weigher }
+        {
+            m_policy.capacity(m_capacity);
+            takeEntries(other);
+        }
+
+        ~LRUCache()
+        {
+            clear();
+        }
+
+        LRUCache& operator=(const LRUCache& other)
         {
-            auto itMap{ m_map.find(key) };
-            if (itMap == m_map.end())
+            if (this != &other)
             {
-                if (m_capacity != 0)
+                clear();
+                m_capacity = other.m_capacity;
+                m_preallocate = other.m_preallocate;
+                m_hasher = other.m_hasher;
+                m_keyEqual = other.m_keyEqual;
+                m_weigher = other.m_weigher;
+                m_policy = PolicyType{};
+                m_policy.capacity(m_capacity);
+                m_expiry = other.m_expiry;
+
+                if (m_preallocate)
                 {
-                    // If cache is full, evict the least recently used item
-                    if (m_capacity <= size())
-                    {
-                        evictLRU();
-                    }
-
-                    m_list.push_front(key);
-                    m_map.emplace(key, std::make_pair(value, m_list.begin()));
+                    reserve(maxNodes());
                 }
+
+                copyEntries(other);
             }
-            else
+
+            return *this;
+        }
+
+        LRUCache& operator=(LRUCache&& other)
+        {
+            if (this != &other)
             {
-                // Replace value in cache with new value
-                itMap->second.first = value;
-                moveToFront(itMap);
+                clear();
+                m_capacity = other.m_capacity;
+                m_preallocate = other.m_preallocate;
+                m_hasher = other.m_hasher;
+                m_keyEqual = other.m_keyEqual;
+                m_weigher = other.m_weigher;
+                m_policy = PolicyType{};
+                m_policy.capacity(m_capacity);
+                takeEntries(other);
+            }
+
+            return *this;
+        }
+
+        // Expired entries are counted until they're reclaimed
+        std::size_t size()                  const   { return m_size; }
+        std::size_t weight()                const   { return m_weight; }
+        std::size_t capacity()              const   { return m_capacity; }
+        bool empty()                        const   { return (m_size == 0); }
+        bool contains(const KeyType& key)   const   { return (findUnexpired(key) != nullptr); }
+
+        // Entries inserted without a time to live of their own get this one, zero if they don't expire
+        DurationType timeToLive() const
+        {
+            static_assert(ExpiryType::enabled(), "Entries only expire with an ExpiryT like TimerWheelExpiry");
+            return m_expiry.timeToLive();
+        }
+
+        void timeToLive(const DurationType timeToLive)
+        {
+            static_assert(ExpiryType::enabled(), "Entries only expire with an ExpiryT like TimerWheelExpiry");
+            m_expiry.timeToLive(timeToLive);
+        }
+
+        // True if each hit starts the entry's time to live again
+        bool expireAfterAccess() const
+        {
+            static_assert(ExpiryType::enabled(), "Entries only expire with an ExpiryT like TimerWheelExpiry");
+            return m_expiry.expireAfterAccess();
+        }
+
+        void expireAfterAccess(const bool expireAfterAccess)
+        {
+            static_assert(ExpiryType::enabled(), "Entries only expire with an ExpiryT like TimerWheelExpiry");
+            m_expiry.expireAfterAccess(expireAfterAccess);
+        }
+
+        void capacity(const std::size_t newCapacity)
+        {
+            m_capacity = newCapacity;
+            m_policy.capacity(m_capacity);
+
+            // While cache is above capacity, evict the policy's victim
+            while (m_capacity < m_weight)
+            {
+                evict();
             }
+
+            if (m_preallocate)
+            {
+                reserve(maxNodes());
+            }
+        }
+
+        // Evicts until the entry fits. Returns false if it weighs more than the capacity, then
+        // nothing is evicted for it, but an entry already cached under the key is removed.
+        bool insert(const KeyType& key, const ValueType& value)
+        {
+            const auto timeToLive{ m_expiry.timeToLive() };
+            return insertEntry(key, value, m_expiry.timer(expireEntries(timeToLive != DurationType::zero()), timeToLive));
+        }
+
+        // The entry expires after timeToLive, or never if it's zero. Inserting the key again replaces it.
+        bool insert(const KeyType& key, const ValueType& value, const DurationType timeToLive)
+        {
+            static_assert(ExpiryType::enabled(), "Entries only expire with an ExpiryT like TimerWheelExpiry");
+            return insertEntry(key, value, m_expiry.timer(expireEntries(timeToLive != DurationType::zero()), timeToLive));
         }
 
         bool get(const KeyType& key, ValueType& value)
         {
-            auto itMap{ m_map.find(key) };
-            if (itMap == m_map.end())
+            const auto node{ accessEntry(key) };
+            if (node == nullptr)
             {
                 return false;
             }
 
-            value = itMap->second.first;
-            moveToFront(itMap);
+            value = node->value;
             return true;
         }
 
-        bool remove(const KeyType& key)
+        // Marks the entry as most recently used and returns its value to read or update in place,
+        // or nullptr if it isn't cached. The pointer is valid until the entry is removed or evicted.
+        ValueType* get(const KeyType& key)
+        {
+            const auto node{ accessEntry(key) };
+            return (node != nullptr) ? &(node->value) : nullptr;
+        }
+
+        // Looks up the value without marking it as used, so it's safe alongside other readers.
+        // Pair it with touch() to apply the use later.
+        const ValueType* peek(const KeyType& key) const
+        {
+            const auto node{ findUnexpired(key) };
+            return (node != nullptr) ? &(node->value) : nullptr;
+        }
+
+        // Marks the entry as most recently used, returns false if it isn't cached
+        bool touch(const KeyType& key)
+        {
+            return (accessEntry(key) != nullptr);
+        }
+
+        // The value that would be evicted next, or nullptr if the cache is empty.
+        // Not const as finding it can move the policy on, like a CLOCK hand.
+        const ValueType* nextEvicted()
         {
-            auto itMap{ m_map.find(key) };
-            if (itMap == m_map.end())
+            const auto hook{ m_policy.victim() };
+            return (hook != nullptr) ? &(static_cast<Node*>(hook)->value) : nullptr;
+        }
+
+        bool evict()
+        {
+            if (empty())
             {
                 return false;
             }
 
-            m_list.erase(itMap->second.second);
-            m_map.erase(itMap);
+            if (const auto node{ evictVictim() })
+            {
+                destroyNode(*node);
+            }
+
             return true;
         }
 
+        // An expired entry is removed too, but isn't counted as cached
+        bool remove(const KeyType& key)
+        {
+            const auto node{ findEntry(key, m_hasher(key)) };
+            if (node == nullptr)
+            {
+                return false;
+            }
+
+            const auto isExpired{ isExpiredNow(*node) };
+            removeNode(*node);
+            return !isExpired;
+        }
+
+        // Reclaims expired entries without waiting for the next lookup or insert to, and returns how many.
+        // Entries that expired in the last millisecond or so can be left for next time.
+        std::size_t expire()
+        {
+            static_assert(ExpiryType::enabled(), "Entries only expire with an ExpiryT like TimerWheelExpiry");
+
+            const auto size{ m_size };
+            expireEntries(true);
+            return (size - m_size);
+        }
+
         void clear()
         {
-            m_map.clear();
-            m_list.clear();
+            for (auto& bucket : m_buckets)
+            {
+                for (auto node{ bucket }; node != nullptr; )
+                {
+                    const auto next{ node->chainNext };
+                    destroyNode(*node);
+                    node = next;
+                }
+
+                bucket = nullptr;
+            }
+
+            m_policy.clear();
+            m_expiry.clear();
+            m_size = 0;
+            m_weight = 0;
         }
 
     private:
-        void moveToFront(typename MapType::iterator itMap)
+        bool insertEntry(const KeyType& key, const ValueType& value, const TimerType& timer)
         {
-            // Move item to front of most recently used list
-            auto itList{ itMap->second.second };
-            if (itList != m_list.begin())
+            const auto hash{ m_hasher(key) };
+            const std::size_t weight{ m_weigher(key, value) };
+            const auto fits{ m_capacity != 0 && weight <= m_capacity };
+
+            auto node{ findNode(key, hash) };
+            if (node != nullptr && PolicyType::isResident(*node))
+            {
+                if (!fits)
+                {
+                    // Rather than leave the old value cached
+                    removeNode(*node);
+                    return false;
+                }
+
+                // Replace value in cache with new value
+                node->value = value;
+                m_weight = (m_weight - node->weight()) + weight;
+                node->weight(weight);
+                m_policy.access(*node);
+                m_expiry.schedule(*node, timer);
+
+                // A heavier value can push other entries out
+                while (m_capacity < m_weight)
+                {
+                    evict();
+                }
+
+                return true;
+            }
+
+            if (!fits)
+            {
+                return false;
+            }
+
+            if (node != nullptr)
+            {
+                reviveNode(*node, value, weight);
+                m_expiry.schedule(*node, timer);
+                return true;
+            }
+
+            // Evict until the new entry fits, reusing the last evicted item's node for it
+            while (m_capacity < (m_weight + weight))
+            {
+                if (node != nullptr)
+                {
+                    destroyNode(*node);
+                }
+
+                node = evictVictim();
+            }
+
+            if (node != nullptr)
             {
-                m_list.erase(itList);
-                m_list.push_front(itMap->first);
+                try
+                {
+                    node->key = key;
+                    node->value = value;
+                }
+                catch (...)
+                {
+                    destroyNode(*node);
+                    throw;
+                }
 
-                itMap->second.second = m_list.begin();
+                node->hash = hash;
+            }
+            else
+            {
+                reserveBuckets(m_numNodes + 1);
+                node = createNode(hash, key, value);
+            }
+
+            node->weight(weight);
+            linkBucket(*node);
+            m_policy.insert(*node);
+            m_expiry.schedule(*node, timer);
+            ++m_size;
+            m_weight += weight;
+            releaseForgotten();
+            return true;
+        }
+
+        // Fibonacci hashing spreads hashes that only differ in their high bits, like std::hash of integers
+        std::size_t bucketIndex(const std::size_t hash) const
+        {
+            return static_cast<std::size_t>((static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ull) >> m_shift);
+        }
+
+        Node* findNode(const KeyType& key, const std::size_t hash) const
+        {
+            if (m_buckets.empty())
+            {
+                return nullptr;
+            }
+
+            for (auto node{ m_buckets[bucketIndex(hash)] }; node != nullptr; node = node->chainNext)
+            {
+                if (node->hash == hash && m_keyEqual(node->key, key))
+                {
+                    return node;
+                }
+            }
+
+            return nullptr;
+        }
+
+        // Skips keys the policy only remembers
+        Node* findEntry(const KeyType& key, const std::size_t hash) const
+        {
+            const auto node{ findNode(key, hash) };
+            return (node != nullptr && PolicyType::isResident(*node)) ? node : nullptr;
+        }
+
+        // Skips expired entries too, without removing them
+        Node* findUnexpired(const KeyType& key) const
+        {
+            const auto node{ findEntry(key, m_hasher(key)) };
+            return (node != nullptr && !isExpiredNow(*node)) ? node : nullptr;
+        }
+
+        // Reads the clock only if the entry can expire
+        bool isExpiredNow(const Node& node) const
+        {
+            return (m_expiry.isTimed(node) && m_expiry.isExpired(node, m_expiry.now()));
+        }
+
+        // Reclaims expired entries first, reading the clock once for that, the lookup and the access.
+        // An entry that expired but hasn't been reclaimed yet is removed as a miss.
+        Node* accessEntry(const KeyType& key)
+        {
+            const auto now{ expireEntries(false) };
+            const auto node{ findEntry(key, m_hasher(key)) };
+            if (node == nullptr)
+            {
+                return nullptr;
+            }
+
+            if (m_expiry.isExpired(*node, now))
+            {
+                removeNode(*node);
+                return nullptr;
+            }
+
+            m_policy.access(*node);
+            m_expiry.access(*node, now);
+            return node;
+        }
+
+        // Reads the clock and reclaims expired entries, only if an entry can expire or one that can
+        // is about to be added. Returns the time read, or 0 if it wasn't needed.
+        std::int64_t expireEntries(const bool isAddingTimer)
+        {
+            if (!ExpiryType::enabled() || (!isAddingTimer && !m_expiry.hasTimers()))
+            {
+                return 0;
+            }
+
+            const auto now{ m_expiry.now() };
+            m_expiry.advance(now, [this](TimerType& timer)
+            {
+                removeNode(static_cast<Node&>(timer));
+            });
+
+            return now;
+        }
+
+        void removeNode(Node& node)
+        {
+            m_policy.erase(node);
+            m_expiry.unschedule(node);
+            unlinkBucket(node);
+            --m_size;
+            m_weight -= node.weight();
+            destroyNode(node);
+        }
+
+        // Entries and the keys the policy remembers
+        std::size_t maxNodes() const
+        {
+            return m_capacity + PolicyType::maxRemembered(m_capacity);
+        }
+
+        void reserve(const std::size_t numNodes)
+        {
+            reserveBuckets(numNodes);
+
+            if (m_numSlots < numNodes)
+            {
+                addSlab(numNodes - m_numSlots);
             }
         }
 
-        void evictLRU()
+        // Keeps at most one node per bucket on average
+        void reserveBuckets(const std::size_t numNodes)
         {
-            // Evict least recently used item
-            auto itList{ --m_list.end() };
-            m_map.erase(*itList);
-            m_list.erase(itList);
+            if (numNodes <= m_buckets.size())
+            {
+                return;
+            }
+
+            auto numBuckets{ std::max<std::size_t>(m_buckets.size(), 8) };
+            while (numBuckets < numNodes)
+            {
+                numBuckets *= 2;
+            }
+
+            std::vector<Node*> buckets(numBuckets, nullptr);
+            m_buckets.swap(buckets);
+
+            m_shift = 64;
+            for (; numBuckets > 1; numBuckets >>= 1)
+            {
+                --m_shift;
+            }
+
+            for (auto node : buckets)
+            {
+                while (node != nullptr)
+                {
+                    const auto next{ node->chainNext };
+                    linkBucket(*node);
+                    node = next;
+                }
+            }
+        }
+
+        void addSlab(const std::size_t numSlots)
+        {
+            std::unique_ptr<Slot[]> slab{ new Slot[numSlots] };
+
+            // Linked in order so nodes are handed out in memory order
+            for (auto i{ numSlots }; i != 0; --i)
+            {
+                slab[i - 1].nextFree = m_freeSlots;
+                m_freeSlots = &slab[i - 1];
+            }
+
+            m_slabs.push_back(std::move(slab));
+            m_numSlots += numSlots;
+        }
+
+        Node* createNode(const std::size_t hash, const KeyType& key, const ValueType& value)
+        {
+            // Without preallocating, each slab doubles the nodes allocated so far, up to the most nodes the cache needs
+            if (m_freeSlots == nullptr)
+            {
+                const auto maxNodes{ this->maxNodes() };
+                const auto numUnallocated{ (m_numSlots < maxNodes) ? (maxNodes - m_numSlots) : 1 };
+                addSlab(std::min(std::max<std::size_t>(m_numSlots, 8), numUnallocated));
+            }
+
+            // The node overwrites the free link, take the slot off the list first
+            const auto slot{ m_freeSlots };
+            m_freeSlots = slot->nextFree;
+
+            try
+            {
+                const auto node{ new (&(slot->node)) Node{ hash, key, value } };
+                ++m_numNodes;
+                return node;
+            }
+            catch (...)
+            {
+                slot->nextFree = m_freeSlots;
+                m_freeSlots = slot;
+                throw;
+            }
+        }
+
+        void destroyNode(Node& node)
+        {
+            // The node is the slot's first and only member
+            const auto slot{ reinterpret_cast<Slot*>(&node) };
+
+            if (PolicyType::isResident(node))
+            {
+                node.value.~ValueType();
+            }
+
+            node.~Node();
+            --m_numNodes;
+            slot->nextFree = m_freeSlots;
+            m_freeSlots = slot;
+        }
+
+        void linkBucket(Node& node)
+        {
+            auto& bucket{ m_buckets[bucketIndex(node.hash)] };
+            node.chainNext = bucket;
+            bucket = &node;
+        }
+
+        void unlinkBucket(Node& node)
+        {
+            auto link{ &m_buckets[bucketIndex(node.hash)] };
+            while (*link != &node)
+            {
+                link = &((*link)->chainNext);
+            }
+
+            *link = node.chainNext;
+        }
+
+        // Evicts the policy's victim. Returns its node to reuse, or nullptr if the policy remembers its key.
+        Node* evictVictim()
+        {
+            const auto node{ static_cast<Node*>(m_policy.victim()) };
+            m_expiry.unschedule(*node);
+            --m_size;
+            m_weight -= node->weight();
+
+            const auto isRemembered{ m_policy.evict(*node) };
+            if (isRemembered)
+            {
+                node->value.~ValueType();
+            }
+            else
+            {
+                unlinkBucket(*node);
+            }
+
+            // Possibly the one just evicted
+            releaseForgotten();
+            return isRemembered ? nullptr : node;
+        }
+
+        // Frees the remembered keys the policy gave up on
+        void releaseForgotten()
+        {
+            while (const auto forgotten{ static_cast<Node*>(m_policy.forget()) })
+            {
+                unlinkBucket(*forgotten);
+                destroyNode(*forgotten);
+            }
+        }
+
+        // The key is added back where the policy remembered it
+        void reviveNode(Node& node, const ValueType& value, const std::size_t weight)
+        {
+            // Taken off the policy first so making room can't forget it
+            m_policy.erase(node);
+
+            while (m_capacity < (m_weight + weight))
+            {
+                if (const auto evicted{ evictVictim() })
+                {
+                    destroyNode(*evicted);
+                }
+            }
+
+            try
+            {
+                new (&(node.value)) ValueType(value);
+            }
+            catch (...)
+            {
+                unlinkBucket(node);
+                destroyNode(node);
+                throw;
+            }
+
+            node.weight(weight);
+            m_policy.revive(node);
+            ++m_size;
+            m_weight += weight;
+            releaseForgotten();
+        }
+
+        // Inserts in the order the policy would evict them, so the copy keeps the same order.
+        // Entries keep their expiry.
+        void copyEntries(const LRUCache& other)
+        {
+            expireEntries(other.m_expiry.hasTimers());
+
+            other.m_policy.forEachOldestFirst([this](const HookType& hook)
+            {
+                const auto& node{ static_cast<const Node&>(hook) };
+                insertEntry(node.key, node.value, node);
+            });
+        }
+
+        void takeEntries(LRUCache& other)
+        {
+            m_size = other.m_size;
+            m_weight = other.m_weight;
+            m_numNodes = other.m_numNodes;
+            m_buckets.swap(other.m_buckets);
+            m_shift = other.m_shift;
+            m_slabs.swap(other.m_slabs);
+            m_numSlots = other.m_numSlots;
+            m_freeSlots = other.m_freeSlots;
+            m_policy = other.m_policy;
+            m_expiry = std::move(other.m_expiry);
+
+            other.m_size = 0;
+            other.m_weight = 0;
+            other.m_numNodes = 0;
+            other.m_buckets.clear();
+            other.m_shift = 64;
+            other.m_slabs.clear();
+            other.m_numSlots = 0;
+            other.m_freeSlots = nullptr;
+            other.m_policy.clear();
         }
     };
 }
@@ -8,13 +8,51 @@
 #pragma once
 
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
 #include <shared_mutex>
 
 #include "lru_cache.hpp"
 
+// Number of read buffers hits are spread over when reads are buffered, threads pick one by ID
+#ifndef PLUTO_SAFE_LRU_CACHE_READ_BUFFERS
+#define PLUTO_SAFE_LRU_CACHE_READ_BUFFERS 16
+#endif
+
+// Hits each read buffer holds before they're applied, more are dropped until then
+#ifndef PLUTO_SAFE_LRU_CACHE_READ_BUFFER_SIZE
+#define PLUTO_SAFE_LRU_CACHE_READ_BUFFER_SIZE 32
+#endif
+
+// Hits a full read buffer drops while other readers keep the writer lock busy, before
+// the next reader waits for the lock to apply it
+#ifndef PLUTO_SAFE_LRU_CACHE_READ_BUFFER_MAX_DROPS
+#define PLUTO_SAFE_LRU_CACHE_READ_BUFFER_MAX_DROPS 8
+#endif
+
+#ifndef PLUTO_SAFE_LRU_CACHE_LINE_SIZE
+#define PLUTO_SAFE_LRU_CACHE_LINE_SIZE 64
+#endif
+
 namespace pluto
 {
-    template<class KeyT, class ValueT>
+    // How SafeLRUCache::get() records hits, see the SafeLRUCache constructor
+    enum class SafeLRUCacheReads : unsigned char
+    {
+        Locked = 0,     // Each hit takes the writer lock to update the LRU order
+        Buffered        // Hits are buffered, so lookups share the lock
+    };
+
+    template<
+        class KeyT,
+        class ValueT,
+        class HashT     = std::hash<KeyT>,
+        class KeyEqualT = std::equal_to<KeyT>,
+        class PolicyT   = LRUPolicy,
+        class WeigherT  = UnitWeigher>
     class SafeLRUCache
     {
 #if (defined(__cplusplus) && __cplusplus > 201402L) || (defined(_MSVC_LANG) && _MSVC_LANG > 201402L)
@@ -23,26 +61,74 @@ namespace pluto
         typedef std::shared_timed_mutex SharedMutexType;
 #endif
 
-        mutable SharedMutexType         m_mutex{};
-        pluto::LRUCache<KeyT, ValueT>   m_lruCache;
+        typedef pluto::LRUCache<KeyT, ValueT, HashT, KeyEqualT, PolicyT, NoExpiry, WeigherT> LRUCacheType;
+
+        // Hits recorded by readers, applied to the LRU order later by whoever holds the writer lock.
+        // Padded by a cache line so readers on different buffers don't share one, which
+        // alignas can't promise for an array allocated with new before C++17.
+        struct ReadBuffer
+        {
+            std::atomic<bool>           busy        { false };
+            std::atomic<std::size_t>    numDropped  { 0 };      // Since it filled
+            std::vector<KeyT>           keys        {};
+            char                        padding[PLUTO_SAFE_LRU_CACHE_LINE_SIZE];
+        };
+
+        mutable SharedMutexType         m_mutex         {};
+        LRUCacheType                    m_lruCache;
+        std::unique_ptr<ReadBuffer[]>   m_readBuffers   {};     // Only when reads are buffered
 
     public:
-        typedef typename pluto::LRUCache<KeyT, ValueT>::KeyType KeyType;
-        typedef typename pluto::LRUCache<KeyT, ValueT>::ValueType ValueType;
-        typedef typename pluto::LRUCache<KeyT, ValueT>::ListType ListType;
-        typedef typename pluto::LRUCache<KeyT, ValueT>::MapType MapType;
+        typedef typename LRUCacheType::KeyType KeyType;
+        typedef typename LRUCacheType::ValueType ValueType;
+        typedef typename LRUCacheType::HasherType HasherType;
+        typedef typename LRUCacheType::KeyEqualType KeyEqualType;
+        typedef typename LRUCacheType::PolicyType PolicyType;
+        typedef typename LRUCacheType::WeigherType WeigherType;
+
+        // Buffering reads lets get() look entries up under a shared lock. Hits are recorded in read
+        // buffers and applied to the LRU order in batches, when a buffer fills and the writer lock
+        // is free, or before the next insert. A hit is dropped if its buffer is busy or full, so the
+        // order is close to LRU rather than exact, but reads scale with the number of threads. Under
+        // read heavy load the writer lock is rarely free, so once a full buffer has dropped a few
+        // hits the next reader waits for the lock to apply it.
+        // Policies with concurrent hits, like CLOCK, always look entries up under a shared lock
+        // and have nothing to buffer.
+        SafeLRUCache(
+            const std::size_t       capacity,
+            const bool              preallocate = false,
+            const SafeLRUCacheReads reads       = SafeLRUCacheReads::Locked) :
+            m_lruCache{ capacity, preallocate }
+        {
+            if (reads == SafeLRUCacheReads::Buffered && !LRUCacheType::concurrentHits())
+            {
+                m_readBuffers.reset(new ReadBuffer[PLUTO_SAFE_LRU_CACHE_READ_BUFFERS]);
+                for (std::size_t i{ 0 }; i < PLUTO_SAFE_LRU_CACHE_READ_BUFFERS; ++i)
+                {
+                    m_readBuffers[i].keys.reserve(PLUTO_SAFE_LRU_CACHE_READ_BUFFER_SIZE);
+                }
+            }
+        }
 
-        SafeLRUCache(const std::size_t capacity) :
-            m_lruCache{ capacity } {}
+        SafeLRUCache(const std::size_t capacity, const SafeLRUCacheReads reads) :
+            SafeLRUCache{ capacity, false, reads } {}
 
         ~SafeLRUCache() {}
 
+        bool bufferReads() const { return (m_readBuffers != nullptr); }
+
         std::size_t size() const
         {
             const std::shared_lock<SharedMutexType> reader{ m_mutex };
             return m_lruCache.size();
         }
 
+        std::size_t weight() const
+        {
+            const std::shared_lock<SharedMutexType> reader{ m_mutex };
+            return m_lruCache.weight();
+        }
+
         std::size_t capacity() const
         {
             const std::shared_lock<SharedMutexType> reader{ m_mutex };
@@ -64,19 +150,64 @@ namespace pluto
         void capacity(const std::size_t newCapacity)
         {
             const std::unique_lock<SharedMutexType> writer{ m_mutex };
+            applyReads();
             m_lruCache.capacity(newCapacity);
         }
 
-        void insert(const KeyType& key, const ValueType& value)
+        // Returns false if the entry weighs more than the capacity
+        bool insert(const KeyType& key, const ValueType& value)
         {
             const std::unique_lock<SharedMutexType> writer{ m_mutex };
-            m_lruCache.insert(key, value);
+            applyReads();
+            return m_lruCache.insert(key, value);
         }
 
         bool get(const KeyType& key, ValueType& value)
         {
-            const std::unique_lock<SharedMutexType> writer{ m_mutex };
-            return m_lruCache.get(key, value);
+            // Hits only set atomic flags, get() is safe alongside other readers
+            if (LRUCacheType::concurrentHits())
+            {
+                const std::shared_lock<SharedMutexType> reader{ m_mutex };
+                return m_lruCache.get(key, value);
+            }
+
+            if (!bufferReads())
+            {
+                const std::unique_lock<SharedMutexType> writer{ m_mutex };
+                return m_lruCache.get(key, value);
+            }
+
+            ReadBuffer* fullBuffer{ nullptr };
+            {
+                const std::shared_lock<SharedMutexType> reader{ m_mutex };
+
+                const auto found{ m_lruCache.peek(key) };
+                if (found == nullptr)
+                {
+                    return false;
+                }
+
+                value = *found;
+                fullBuffer = recordRead(key);
+            }
+
+            // Apply the buffered reads now if no one else is, or wait to once the buffer has dropped too many hits
+            if (fullBuffer != nullptr)
+            {
+                std::unique_lock<SharedMutexType> writer{ m_mutex, std::try_to_lock };
+                if (!writer.owns_lock() &&
+                    PLUTO_SAFE_LRU_CACHE_READ_BUFFER_MAX_DROPS < fullBuffer->numDropped.load(std::memory_order_relaxed))
+                {
+                    writer.lock();
+                }
+
+                if (writer.owns_lock())
+                {
+                    applyReads();
+                }
+            }
+
+            return true;
         }
 
         bool remove(const KeyType& key)
@@ -90,5 +221,66 @@ namespace pluto
             const std::unique_lock<SharedMutexType> writer{ m_mutex };
             m_lruCache.clear();
         }
+
+    private:
+        // Returns the buffer if it's full and should be applied, otherwise nullptr
+        ReadBuffer* recordRead(const KeyType& key)
+        {
+            // Thread IDs can be aligned addresses, mix them so the low bits differ
+            thread_local const std::size_t threadHash{ static_cast<std::size_t>(
+                (static_cast<std::uint64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) * 0x9E3779B97F4A7C15ull) >> 32) };
+
+            auto& buffer{ m_readBuffers[threadHash % PLUTO_SAFE_LRU_CACHE_READ_BUFFERS] };
+
+            // Another reader or the writer has the buffer, drop the hit
+            if (buffer.busy.exchange(true, std::memory_order_acquire))
+            {
+                return nullptr;
+            }
+
+            if (buffer.keys.size() < PLUTO_SAFE_LRU_CACHE_READ_BUFFER_SIZE)
+            {
+                try
+                {
+                    buffer.keys.push_back(key);
+                }
+                catch (...) {}
+            }
+            else
+            {
+                buffer.numDropped.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            const auto isFull{ PLUTO_SAFE_LRU_CACHE_READ_BUFFER_SIZE <= buffer.keys.size() };
+            buffer.busy.store(false, std::memory_order_release);
+            return isFull ? &buffer : nullptr;
+        }
+
+        // Must hold the writer lock. Entries removed since they were read are skipped.
+        void applyReads()
+        {
+            if (!bufferReads())
+            {
+                return;
+            }
+
+            for (std::size_t i{ 0 }; i < PLUTO_SAFE_LRU_CACHE_READ_BUFFERS; ++i)
+            {
+                auto& buffer{ m_readBuffers[i] };
+                if (buffer.busy.exchange(true, std::memory_order_acquire))
+                {
+                    continue;
+                }
+
+                for (const auto& key : buffer.keys)
+                {
+                    m_lruCache.touch(key);
+                }
+
+                buffer.keys.clear();
+                buffer.numDropped.store(0, std::memory_order_relaxed);
+                buffer.busy.store(false, std::memory_order_release);
+            }
+        }
     };
 }
@@ -0,0 +1,378 @@
+/*
+* Copyright (c) 2024 Stephen O Driscoll
+*
+* Distributed under the MIT License (See accompanying file LICENSE)
+* Official repository: https://github.com/Stephen-ODriscoll/PlutoUtils
+*/
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+#include "lru_cache.hpp"
+
+#ifndef PLUTO_SHARDED_LRU_CACHE_LINE_SIZE
+#define PLUTO_SHARDED_LRU_CACHE_LINE_SIZE 64
+#endif
+
+// Number of shards compared when picking an entry to evict in approximate global LRU mode
+#ifndef PLUTO_SHARDED_LRU_CACHE_EVICTION_SAMPLES
+#define PLUTO_SHARDED_LRU_CACHE_EVICTION_SAMPLES 4
+#endif
+
+namespace pluto
+{
+    // Splits entries between independent LRU caches by key hash, each with its own lock,
+    // so threads only contend when their keys land in the same shard.
+    //
+    // By default the capacity is divided between the shards and each evicts its own least
+    // recently used entries. In approximate global LRU mode any shard can grow to the full
+    // capacity, and once the cache is full the least recently used entries of a few shards
+    // are compared and the oldest is evicted, which is closer to one LRU cache when keys are skewed.
+    //
+    // With a WeigherT the capacity is a total weight, as in LRUCache. Unless in approximate global
+    // LRU mode, an entry has to fit in its shard's share of the capacity.
+    //
+    // Every shard gets a share of at least 1, so a capacity below the number of shards is raised
+    // to one entry per shard rather than leaving shards that can't hold anything.
+    template<
+        class KeyT,
+        class ValueT,
+        std::size_t Shards  = 16,
+        class HashT         = std::hash<KeyT>,
+        class KeyEqualT     = std::equal_to<KeyT>,
+        class PolicyT       = LRUPolicy,
+        class WeigherT      = UnitWeigher>
+    class ShardedLRUCache
+    {
+        static_assert(Shards != 0, "ShardedLRUCache needs at least one shard");
+
+        typedef std::chrono::steady_clock Clock;
+
+        struct Entry
+        {
+            ValueT      value;
+            Clock::rep  lastUsed;   // Only kept in approximate global LRU mode
+        };
+
+        // Weighs the value without the time it was last used
+        struct EntryWeigher
+        {
+            WeigherT weigher;
+
+            std::size_t operator()(const KeyT& key, const Entry& entry) const { return weigher(key, entry.value); }
+        };
+
+        typedef typename std::conditional<std::is_same<WeigherT, UnitWeigher>::value, UnitWeigher, EntryWeigher>::type EntryWeigherType;
+        typedef pluto::LRUCache<KeyT, Entry, HashT, KeyEqualT, PolicyT, NoExpiry, EntryWeigherType> LRUCacheType;
+
+        // Padded by a cache line so no two shards share one. Unlike alignas, this holds
+        // wherever the cache is allocated, including with new before C++17.
+        struct Shard
+        {
+            mutable std::mutex  mutex       {};
+            LRUCacheType        lruCache    { 0 };
+            char                padding[PLUTO_SHARDED_LRU_CACHE_LINE_SIZE];
+        };
+
+        std::array<Shard, Shards>       m_shards    {};
+        bool                            m_globalLRU;
+        std::atomic<std::size_t>        m_capacity;         // Only kept in approximate global LRU mode
+        std::atomic<std::ptrdiff_t>     m_weight    { 0 };  // Signed, updates from racing threads can land out of order
+        HashT                           m_hasher    {};
+
+    public:
+        typedef KeyT KeyType;
+        typedef ValueT ValueType;
+        typedef HashT HasherType;
+        typedef KeyEqualT KeyEqualType;
+        typedef PolicyT PolicyType;
+        typedef WeigherT WeigherType;
+
+        // Preallocating allocates each shard's share of the capacity up front.
+        // It's ignored in approximate global LRU mode, where a shard has no fixed share.
+        ShardedLRUCache(const std::size_t capacity, const bool preallocate = false, const bool approximateGlobalLRU = false) :
+            m_globalLRU { approximateGlobalLRU },
+            m_capacity  { capacity }
+        {
+            for (std::size_t i{ 0 }; i < Shards; ++i)
+            {
+                m_shards[i].lruCache = LRUCacheType{ shardCapacity(capacity, i), (preallocate && !m_globalLRU) };
+            }
+        }
+
+        ~ShardedLRUCache() {}
+
+        ShardedLRUCache(const ShardedLRUCache&) = delete;
+        ShardedLRUCache& operator=(const ShardedLRUCache&) = delete;
+
+        static constexpr std::size_t shards()   { return Shards; }
+        bool approximateGlobalLRU()     const   { return m_globalLRU; }
+
+        // Each shard is locked in turn, so with concurrent writers this is a snapshot at best
+        std::size_t size() const
+        {
+            std::size_t size{ 0 };
+            for (const auto& shard : m_shards)
+            {
+                const std::lock_guard<std::mutex> lock{ shard.mutex };
+                size += shard.lruCache.size();
+            }
+
+            return size;
+        }
+
+        std::size_t weight() const
+        {
+            std::size_t weight{ 0 };
+            for (const auto& shard : m_shards)
+            {
+                const std::lock_guard<std::mutex> lock{ shard.mutex };
+                weight += shard.lruCache.weight();
+            }
+
+            return weight;
+        }
+
+        // The weight in each shard, to see how evenly keys spread
+        std::array<std::size_t, Shards> shardWeights() const
+        {
+            std::array<std::size_t, Shards> weights{};
+            for (std::size_t i{ 0 }; i < Shards; ++i)
+            {
+                const std::lock_guard<std::mutex> lock{ m_shards[i].mutex };
+                weights[i] = m_shards[i].lruCache.weight();
+            }
+
+            return weights;
+        }
+
+        std::size_t capacity() const
+        {
+            if (m_globalLRU)
+            {
+                return m_capacity.load();
+            }
+
+            std::size_t capacity{ 0 };
+            for (const auto& shard : m_shards)
+            {
+                const std::lock_guard<std::mutex> lock{ shard.mutex };
+                capacity += shard.lruCache.capacity();
+            }
+
+            return capacity;
+        }
+
+        bool empty() const
+        {
+            for (const auto& shard : m_shards)
+            {
+                const std::lock_guard<std::mutex> lock{ shard.mutex };
+                if (!shard.lruCache.empty())
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        bool contains(const KeyType& key) const
+        {
+            const auto& shard{ m_shards[shardIndex(key)] };
+            const std::lock_guard<std::mutex> lock{ shard.mutex };
+            return shard.lruCache.contains(key);
+        }
+
+        void capacity(const std::size_t newCapacity)
+        {
+            m_capacity = newCapacity;
+
+            for (std::size_t i{ 0 }; i < Shards; ++i)
+            {
+                auto& lruCache{ m_shards[i].lruCache };
+                const std::lock_guard<std::mutex> lock{ m_shards[i].mutex };
+
+                // In approximate global LRU mode a shard only evicts here if it holds more than the whole capacity
+                const auto weight{ lruCache.weight() };
+                lruCache.capacity(shardCapacity(newCapacity, i));
+                m_weight -= static_cast<std::ptrdiff_t>(weight - lruCache.weight());
+            }
+
+            if (m_globalLRU)
+            {
+                evictOverCapacity(0);
+            }
+        }
+
+        // Returns false if the entry weighs more than the capacity, or its shard's share of it
+        bool insert(const KeyType& key, const ValueType& value)
+        {
+            const auto index{ shardIndex(key) };
+            auto& shard{ m_shards[index] };
+
+            if (!m_globalLRU)
+            {
+                const std::lock_guard<std::mutex> lock{ shard.mutex };
+                return shard.lruCache.insert(key, Entry{ value, 0 });
+            }
+
+            bool inserted{ false };
+            std::ptrdiff_t addedWeight{ 0 };
+            {
+                const std::lock_guard<std::mutex> lock{ shard.mutex };
+                const auto weight{ shard.lruCache.weight() };
+                inserted = shard.lruCache.insert(key, Entry{ value, Clock::now().time_since_epoch().count() });
+                addedWeight = static_cast<std::ptrdiff_t>(shard.lruCache.weight()) - static_cast<std::ptrdiff_t>(weight);
+            }
+
+            // Negative if a lighter value replaced a heavier one
+            m_weight += addedWeight;
+            if (0 < addedWeight)
+            {
+                evictOverCapacity(index);
+            }
+
+            return inserted;
+        }
+
+        bool get(const KeyType& key, ValueType& value)
+        {
+            auto& shard{ m_shards[shardIndex(key)] };
+            const std::lock_guard<std::mutex> lock{ shard.mutex };
+
+            const auto entry{ shard.lruCache.get(key) };
+            if (entry == nullptr)
+            {
+                return false;
+            }
+
+            value = entry->value;
+
+            if (m_globalLRU)
+            {
+                entry->lastUsed = Clock::now().time_since_epoch().count();
+            }
+
+            return true;
+        }
+
+        bool remove(const KeyType& key)
+        {
+            auto& shard{ m_shards[shardIndex(key)] };
+            bool removed{ false };
+            std::size_t removedWeight{ 0 };
+            {
+                const std::lock_guard<std::mutex> lock{ shard.mutex };
+                const auto weight{ shard.lruCache.weight() };
+                removed = shard.lruCache.remove(key);
+                removedWeight = weight - shard.lruCache.weight();
+            }
+
+            if (m_globalLRU)
+            {
+                m_weight -= static_cast<std::ptrdiff_t>(removedWeight);
+            }
+
+            return removed;
+        }
+
+        void clear()
+        {
+            for (auto& shard : m_shards)
+            {
+                std::size_t weight{ 0 };
+                {
+                    const std::lock_guard<std::mutex> lock{ shard.mutex };
+                    weight = shard.lruCache.weight();
+                    shard.lruCache.clear();
+                }
+
+                if (m_globalLRU)
+                {
+                    m_weight -= static_cast<std::ptrdiff_t>(weight);
+                }
+            }
+        }
+
+    private:
+        // Mixed with a different constant to the one LRUCache picks buckets with,
+        // so the keys in one shard still spread over all of its buckets
+        std::size_t shardIndex(const KeyType& key) const
+        {
+            const auto mixed{ static_cast<std::uint64_t>(m_hasher(key)) * 0xFF51AFD7ED558CCDull };
+            return static_cast<std::size_t>((mixed >> 32) % Shards);
+        }
+
+        std::size_t shardCapacity(const std::size_t capacity, const std::size_t index) const
+        {
+            if (m_globalLRU)
+            {
+                return capacity;
+            }
+
+            if (capacity == 0)
+            {
+                return 0;
+            }
+
+            // The first shards take the remainder
+            return std::max<std::size_t>(((capacity / Shards) + ((index < (capacity % Shards)) ? 1 : 0)), 1);
+        }
+
+        // Evicts from whichever of the sampled shards has the oldest least recently used entry.
+        // Sampling starts at the shard just inserted into, so successive inserts sample different shards.
+        void evictOverCapacity(const std::size_t firstIndex)
+        {
+            const std::size_t numSamples{ std::min<std::size_t>(PLUTO_SHARDED_LRU_CACHE_EVICTION_SAMPLES, Shards) };
+            std::size_t numEmptySampled{ 0 };
+
+            for (std::size_t attempt{ 0 }; static_cast<std::ptrdiff_t>(m_capacity.load()) < m_weight.load(); ++attempt)
+            {
+                Shard* victim{ nullptr };
+                Clock::rep oldest{ 0 };
+
+                for (std::size_t i{ 0 }; i < numSamples; ++i)
+                {
+                    auto& shard{ m_shards[(firstIndex + (attempt * numSamples) + i) % Shards] };
+                    const std::lock_guard<std::mutex> lock{ shard.mutex };
+
+                    const auto entry{ shard.lruCache.nextEvicted() };
+                    if (entry != nullptr && (victim == nullptr || entry->lastUsed < oldest))
+                    {
+                        victim = &shard;
+                        oldest = entry->lastUsed;
+                    }
+                }
+
+                if (victim != nullptr)
+                {
+                    numEmptySampled = 0;
+                    std::size_t evictedWeight{ 0 };
+                    {
+                        // The entry may have been used since, it's still one of the oldest
+                        const std::lock_guard<std::mutex> lock{ victim->mutex };
+                        const auto weight{ victim->lruCache.weight() };
+                        victim->lruCache.evict();
+                        evictedWeight = weight - victim->lruCache.weight();
+                    }
+
+                    m_weight -= static_cast<std::ptrdiff_t>(evictedWeight);
+                }
+                else if (Shards <= (numEmptySampled += numSamples))
+                {
+                    // Every shard is empty, the weight is behind a removal that hasn't been counted yet
+                    return;
+                }
+            }
+        }
+    };
+}
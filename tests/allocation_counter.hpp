@@ -0,0 +1,69 @@
+/*
+* Copyright (c) 2024 Stephen O Driscoll
+*
+* Distributed under the MIT License (See accompanying file LICENSE)
+* Official repository: https://github.com/Stephen-ODriscoll/PlutoUtils
+*/
+
+// Replaces the global operator new and delete to count allocations, so include it in exactly one
+// source file of a binary that measures them. The unit tests include it in their own binary,
+// pluto_allocation_tests, so the rest of the tests run with the standard allocator.
+
+#pragma once
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+
+// Only counted while g_countAllocations is set, so counting doesn't slow anything else down.
+// The bytes in use are tracked through sized deletes, which std::allocator and deleting a complete
+// type both use, so unsized deletes aren't subtracted.
+static std::atomic_bool g_countAllocations{ false };
+static std::atomic_size_t g_numAllocations{ 0 };
+static std::atomic<long long> g_numBytesInUse{ 0 };
+static thread_local std::size_t t_numAllocations{ 0 };
+
+// Kept out of line so GCC doesn't pair the free in an inlined delete with this operator new
+// where the standard containers are inlined (-Wmismatched-new-delete)
+#ifdef _MSC_VER
+#define ALLOCATION_COUNTER_NOINLINE __declspec(noinline)
+#else
+#define ALLOCATION_COUNTER_NOINLINE __attribute__((noinline))
+#endif
+
+ALLOCATION_COUNTER_NOINLINE void* operator new(std::size_t size)
+{
+    const auto isCounting{ g_countAllocations.load(std::memory_order_relaxed) };
+    if (isCounting)
+    {
+        g_numAllocations.fetch_add(1, std::memory_order_relaxed);
+        ++t_numAllocations;
+    }
+
+    if (void* const ptr{ std::malloc((size == 0) ? 1 : size) })
+    {
+        if (isCounting)
+        {
+            g_numBytesInUse.fetch_add(static_cast<long long>(size), std::memory_order_relaxed);
+        }
+
+        return ptr;
+    }
+
+    throw std::bad_alloc{};
+}
+
+ALLOCATION_COUNTER_NOINLINE void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+ALLOCATION_COUNTER_NOINLINE void operator delete(void* ptr, std::size_t size) noexcept
+{
+    if (g_countAllocations.load(std::memory_order_relaxed))
+    {
+        g_numBytesInUse.fetch_sub(static_cast<long long>(size), std::memory_order_relaxed);
+    }
+
+    std::free(ptr);
+}
@@ -0,0 +1,76 @@
+/*
+* Copyright (c) 2024 Stephen O Driscoll
+*
+* Distributed under the MIT License (See accompanying file LICENSE)
+* Official repository: https://github.com/Stephen-ODriscoll/PlutoUtils
+*/
+
+#include "pluto/lru_cache.hpp"
+
+#include <random>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#include "allocation_counter.hpp"
+
+#define ALLOCATION_CACHE_CAPACITY 100
+
+// Churns the cache with new keys and keys it remembers. Returns the allocations once it's full, and
+// during a second round once every key the policy remembers has a node.
+template<class PolicyT>
+std::pair<std::size_t, std::size_t> countSteadyStateAllocations(const bool preallocate)
+{
+    pluto::LRUCache<std::size_t, std::size_t, std::hash<std::size_t>, std::equal_to<std::size_t>, PolicyT> policyCache{
+        ALLOCATION_CACHE_CAPACITY, preallocate };
+
+    std::size_t numAllocations[2]{};
+    for (auto& roundAllocations : numAllocations)
+    {
+        std::mt19937 random{ 1 };
+        std::uniform_int_distribution<std::size_t> keys{ 0, (ALLOCATION_CACHE_CAPACITY * 3) - 1 };
+
+        for (std::size_t i{ 0 }; i < ALLOCATION_CACHE_CAPACITY; ++i)
+        {
+            policyCache.insert(i, i);
+        }
+
+        const auto before{ t_numAllocations };
+        g_countAllocations.store(true);
+
+        for (std::size_t i{ 0 }; i < (ALLOCATION_CACHE_CAPACITY * 50); ++i)
+        {
+            const auto key{ keys(random) };
+            if (policyCache.get(key) == nullptr)
+            {
+                policyCache.insert(key, key);
+            }
+        }
+
+        g_countAllocations.store(false);
+        roundAllocations = (t_numAllocations - before);
+    }
+
+    return { numAllocations[0], numAllocations[1] };
+}
+
+template<class PolicyT>
+void testSteadyStateAllocations()
+{
+    // Preallocated, remembered keys have nodes from the start
+    const auto preallocated{ countSteadyStateAllocations<PolicyT>(true) };
+    ASSERT_EQ(preallocated.first, 0);
+    ASSERT_EQ(preallocated.second, 0);
+
+    // Otherwise a few growing slabs and bucket tables, rather than a slab per remembered key
+    const auto allocated{ countSteadyStateAllocations<PolicyT>(false) };
+    ASSERT_LE(allocated.first, 8);
+    ASSERT_EQ(allocated.second, 0);
+}
+
+TEST(AllocationTests, TestRememberedKeysDontAllocate)
+{
+    testSteadyStateAllocations<pluto::ARCPolicy>();
+    testSteadyStateAllocations<pluto::TwoQueuePolicy>();
+    testSteadyStateAllocations<pluto::ClockProPolicy>();
+}
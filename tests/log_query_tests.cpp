@@ -0,0 +1,73 @@
+/*
+* Copyright (c) 2024 Stephen O Driscoll
+*
+* Distributed under the MIT License (See accompanying file LICENSE)
+* Official repository: https://github.com/Stephen-ODriscoll/PlutoUtils
+*/
+
+#include "log_query/log_query.hpp"
+
+#include <gtest/gtest.h>
+
+#define QUERY_FILE "test_query.log"
+
+class LogQueryTests : public testing::Test
+{
+protected:
+    LogQueryTests() {}
+
+    ~LogQueryTests() {}
+
+    void TearDown() override
+    {
+        std::error_code error{};
+        pluto::FileSystem::remove(QUERY_FILE, error);
+        pluto::FileSystem::remove(pluto::Logger::getIndexFilePath(QUERY_FILE), error);
+    }
+};
+
+TEST_F(LogQueryTests, TestParseArguments)
+{
+    const char* const arguments[]{ "pluto_log_query", "--level", "Error", "--separator", ";", QUERY_FILE };
+
+    Query query{};
+    std::vector<std::string> fileNames{};
+
+    ASSERT_TRUE(parseArguments(6, arguments, query, fileNames));
+    ASSERT_EQ(query.level, "Error");
+    ASSERT_EQ(query.separator, ";");
+    ASSERT_EQ(fileNames, std::vector<std::string>{ QUERY_FILE });
+}
+
+TEST_F(LogQueryTests, TestEmptySeparatorRejected)
+{
+    const char* const arguments[]{ "pluto_log_query", "--separator", "", QUERY_FILE };
+
+    Query query{};
+    std::vector<std::string> fileNames{};
+
+    ASSERT_FALSE(parseArguments(4, arguments, query, fileNames));
+}
+
+TEST_F(LogQueryTests, TestFindRangeOffsetsPastEnd)
+{
+    // Left from a longer file, every entry is past the end of this one
+    {
+        std::ofstream indexStream{ pluto::Logger::getIndexFilePath(QUERY_FILE), std::ios_base::binary };
+        for (std::int64_t i{ 0 }; i < 4; ++i)
+        {
+            const pluto::Logger::IndexEntry entry{ (i * 1'000'000'000), static_cast<std::uint64_t>(1000 + i * 1000) };
+            indexStream.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        }
+    }
+
+    Query query{};
+    query.from = "2100-01-01";
+
+    std::size_t begin{ 0 };
+    std::size_t end{ 100 };
+    findRange(QUERY_FILE, query, begin, end);
+
+    ASSERT_LE(begin, end);
+    ASSERT_LE(end, 100);
+}
@@ -10,6 +10,10 @@
 #include <gtest/gtest.h>
 
 #define LOG_FILE "test.log"
+#define ROUTE_FILE "test_route.log"
+#define MAPPED_FILE "test_mapped.log"
+#define SPILL_FILE "test_spill.log"
+#define ROTATION_DIR "test_rotation"
 
 #define LOG_FORMAT(...)             PLUTO_LOG_FORMAT_NONE(LOG_FILE, __VA_ARGS__)
 #define LOG_FORMAT_FATAL(...)       PLUTO_LOG_FORMAT_FATAL(LOG_FILE, __VA_ARGS__)
@@ -46,16 +50,36 @@ protected:
         {
             pluto::FileSystem::remove(LOG_FILE);
         }
+
+        if (pluto::FileSystem::exists(ROUTE_FILE))
+        {
+            pluto::FileSystem::remove(ROUTE_FILE);
+        }
+
+        if (pluto::FileSystem::exists(MAPPED_FILE))
+        {
+            pluto::FileSystem::remove(MAPPED_FILE);
+        }
+
+        if (pluto::FileSystem::exists(SPILL_FILE))
+        {
+            pluto::FileSystem::remove(SPILL_FILE);
+        }
+
+        if (pluto::FileSystem::exists(ROTATION_DIR))
+        {
+            pluto::FileSystem::remove_all(ROTATION_DIR);
+        }
     }
 };
 
-std::size_t countLogs()
+std::size_t countLogs(const char* const fileName = LOG_FILE)
 {
     std::this_thread::sleep_for(std::chrono::milliseconds(50));
 
     std::string lastLog{};
     std::size_t logCount{ 0 };
-    std::ifstream logFile{ LOG_FILE };
+    std::ifstream logFile{ fileName };
 
     if (logFile.is_open() && logFile.good())
     {
@@ -184,6 +208,20 @@ TEST_F(LoggerTests, TestLogFormatDoesFormatting)
     ASSERT_EQ("log message: Test, Test", getLastLogMessage());
 }
 
+TEST_F(LoggerTests, TestLogFormatLongMessage)
+{
+    const std::string longText(20000, 'x');
+
+    LOG_FORMAT("short %s", "message");
+    ASSERT_EQ("short message", getLastLogMessage());
+
+    LOG_FORMAT("long %s", longText.c_str());
+    ASSERT_EQ("long " + longText, getLastLogMessage());
+
+    LOG_FORMAT("short %s", "message");
+    ASSERT_EQ("short message", getLastLogMessage());
+}
+
 TEST_F(LoggerTests, TestLogFormatBrokenStillLogs)
 {
     LOG_FORMAT("log message: %s, %S", "Test");
@@ -229,3 +267,747 @@ TEST_F(LoggerTests, TestAllStreamLogsAreWritten)
 
     ASSERT_EQ(countLogs(), 1002);   // +2 for header
 }
+
+TEST_F(LoggerTests, TestWriteCopiesOrMovesMessage)
+{
+    auto& logger{ pluto::Logger::getInstance() };
+
+    const std::string copied{ "Copied log message" };
+    logger.write(LOG_FILE, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, copied);
+    ASSERT_EQ(copied, "Copied log message");
+    ASSERT_EQ("Copied log message", getLastLogMessage());
+
+    std::string moved{ "Moved log message long enough to be allocated on the heap" };
+    logger.write(LOG_FILE, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, std::move(moved));
+    ASSERT_EQ("Moved log message long enough to be allocated on the heap", getLastLogMessage());
+}
+
+TEST_F(LoggerTests, TestWriterIndex)
+{
+    auto& logger{ pluto::Logger::getInstance() };
+
+    ASSERT_LE(1, logger.numWriters());
+    ASSERT_LT(logger.writerIndex(LOG_FILE), logger.numWriters());
+
+    logger.writerIndex(LOG_FILE, logger.numWriters());
+    ASSERT_EQ(logger.writerIndex(LOG_FILE), 0);
+
+    LOG_STREAM("log message");
+    ASSERT_EQ("log message", getLastLogMessage());
+}
+
+TEST_F(LoggerTests, TestWriterIndexAfterLogging)
+{
+    {
+        pluto::Logger logger{ 4 };
+        logger.write(LOG_FILE, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, "First log message");
+
+        const auto index{ (logger.writerIndex(LOG_FILE) + 1) % logger.numWriters() };
+        logger.writerIndex(LOG_FILE, index);
+        ASSERT_EQ(logger.writerIndex(LOG_FILE), index);
+
+        logger.write(LOG_FILE, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, "Second log message");
+    }
+
+    ASSERT_EQ(countLogs(), 4);  // +2 for header
+}
+
+TEST_F(LoggerTests, TestTimestampFractions)
+{
+    const auto timestamp{ pluto::Logger::Clock::from_time_t(0) + std::chrono::milliseconds(5) };
+
+    {
+        pluto::Logger logger{};
+        logger
+            .metaDataColumns({ pluto::Logger::MetaDataColumn::Timestamp })
+            .timestampFormat("%.3S|%.6S")
+            .timestampLength(0)
+            .bufferRecycleCapacity(0);
+
+        logger.write(timestamp, LOG_FILE, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, std::string("First"));
+        logger.write(timestamp + std::chrono::seconds(1), LOG_FILE, pluto::Logger::Level::None,
+            __FILE__, __LINE__, __func__, std::string("Second"));
+    }
+
+    ASSERT_EQ(getLastLog(), "005|005000 | Second");
+}
+
+TEST_F(LoggerTests, TestRoutes)
+{
+    std::mutex mutex{};
+    std::vector<std::string> routedLogs{};
+
+    pluto::Logger::getInstance()
+        .route(LOG_FILE, pluto::Logger::Level::Error, ROUTE_FILE)
+        .route(LOG_FILE, pluto::Logger::Level::Error,
+            [&](const pluto::Logger::Level, const std::string& log)
+            {
+                const std::unique_lock<std::mutex> lock{ mutex };
+                routedLogs.push_back(log);
+            });
+
+    LOG_STREAM_FATAL("Fatal log message");
+    LOG_STREAM_ERROR("Error log message");
+    LOG_STREAM_INFO("Info log message");
+    LOG_STREAM_DEBUG("Debug log message");
+
+    ASSERT_EQ(countLogs(), 6);              // +2 for header
+    ASSERT_EQ(countLogs(ROUTE_FILE), 4);    // +2 for header
+
+    pluto::Logger::getInstance().clearRoutes(LOG_FILE);
+
+    const std::unique_lock<std::mutex> lock{ mutex };
+    ASSERT_EQ(routedLogs.size(), 2);
+    ASSERT_NE(routedLogs[1].find("Error log message"), std::string::npos);
+}
+
+class MemorySink : public pluto::Logger::Sink
+{
+public:
+    std::mutex mutex{};
+    std::vector<std::string> logs{};
+    std::size_t numBatches{ 0 };
+    std::size_t maxBatchSize{ 0 };
+
+    bool write(const pluto::Logger::LogBatch& batch) override
+    {
+        const std::unique_lock<std::mutex> lock{ mutex };
+
+        for (const pluto::Logger::LogRecord* const log : batch)
+        {
+            logs.push_back(log->message);
+        }
+
+        ++numBatches;
+        maxBatchSize = (std::max)(maxBatchSize, batch.size());
+        return true;
+    }
+};
+
+TEST_F(LoggerTests, TestCustomSink)
+{
+    auto sink{ std::make_shared<MemorySink>() };
+    pluto::Logger::getInstance().sink(LOG_FILE, sink);
+
+    LOG_STREAM_ERROR("Error log message");
+    LOG_STREAM_INFO("Info log message");
+
+    ASSERT_EQ(countLogs(), 0);
+    pluto::Logger::getInstance().sink(LOG_FILE, nullptr);
+
+    const std::unique_lock<std::mutex> lock{ sink->mutex };
+    ASSERT_EQ(sink->logs.size(), 2);
+    ASSERT_EQ(sink->logs[0], "Error log message");
+    ASSERT_EQ(sink->logs[1], "Info log message");
+    ASSERT_LE(1, sink->numBatches);
+}
+
+class FailingSink : public pluto::Logger::Sink
+{
+public:
+    std::atomic_size_t numWrites{ 0 };
+
+    bool write(const pluto::Logger::LogBatch&) override
+    {
+        ++numWrites;
+        return false;
+    }
+};
+
+TEST_F(LoggerTests, TestFailingSinkBacksOff)
+{
+    auto sink{ std::make_shared<FailingSink>() };
+
+    {
+        pluto::Logger logger{};
+        logger.sink(LOG_FILE, sink);
+        logger.write(LOG_FILE, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, "log message");
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        ASSERT_LE(2, sink->numWrites.load());
+        ASSERT_LE(sink->numWrites.load(), 10);
+    }
+}
+
+TEST_F(LoggerTests, TestPeriodFilePath)
+{
+    std::tm localTime{};
+    localTime.tm_year = 2026 - 1900;
+    localTime.tm_mon = 9;
+    localTime.tm_mday = 17;
+    localTime.tm_hour = 13;
+    localTime.tm_min = 25;
+    localTime.tm_isdst = -1;
+
+    const auto timestamp{ pluto::Logger::Clock::from_time_t(std::mktime(&localTime)) };
+    const pluto::FileSystem::path filePath{ "logs/app.log" };
+    pluto::Logger::Clock::time_point nextRotationTime{};
+
+    auto periodPath{ pluto::Logger::getPeriodFilePath(
+        filePath, pluto::Logger::FileRotationPeriod::Hourly, timestamp, nextRotationTime) };
+
+    ASSERT_EQ(periodPath, pluto::FileSystem::path{ "logs/app.2026-10-17T13.log" });
+    ASSERT_EQ(nextRotationTime, timestamp + std::chrono::minutes(35));
+
+    periodPath = pluto::Logger::getPeriodFilePath(
+        filePath, pluto::Logger::FileRotationPeriod::Daily, timestamp, nextRotationTime);
+
+    ASSERT_EQ(periodPath, pluto::FileSystem::path{ "logs/app.2026-10-17.log" });
+    ASSERT_EQ(pluto::Logger::getLocalTimestamp("%Y-%m-%d %H:%M:%S", nextRotationTime), "2026-10-18 00:00:00");
+
+    periodPath = pluto::Logger::getPeriodFilePath(
+        filePath, pluto::Logger::FileRotationPeriod::None, timestamp, nextRotationTime);
+
+    ASSERT_EQ(periodPath, filePath);
+    ASSERT_EQ(nextRotationTime, pluto::Logger::Clock::time_point::max());
+}
+
+TEST_F(LoggerTests, TestFileRotationPeriod)
+{
+    const std::string logFile{ ROTATION_DIR "/app.log" };
+    const pluto::FileSystem::path expiredFile{ ROTATION_DIR "/app.2000-01-01T00.log" };
+    const pluto::FileSystem::path otherFile{ ROTATION_DIR "/app.other.log" };
+
+    pluto::FileSystem::create_directories(ROTATION_DIR);
+    std::ofstream{ expiredFile } << "expired log\n";
+    std::ofstream{ otherFile } << "other log\n";
+    pluto::FileSystem::last_write_time(expiredFile,
+        pluto::FileSystem::file_time_type::clock::now() - std::chrono::hours(48));
+
+    const auto before{ pluto::Logger::getLocalTimestamp("%Y-%m-%dT%H") };
+
+    {
+        pluto::Logger logger{};
+        logger
+            .fileRotationPeriod(pluto::Logger::FileRotationPeriod::Hourly)
+            .fileRetentionAge(24 * 60 * 60);
+
+        logger.write(logFile, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, "log message");
+    }
+
+    const auto after{ pluto::Logger::getLocalTimestamp("%Y-%m-%dT%H") };
+
+    ASSERT_FALSE(pluto::FileSystem::exists(logFile));
+    ASSERT_FALSE(pluto::FileSystem::exists(expiredFile));
+    ASSERT_TRUE(pluto::FileSystem::exists(otherFile));
+    ASSERT_TRUE(pluto::FileSystem::exists(ROTATION_DIR "/app." + before + ".log") ||
+        pluto::FileSystem::exists(ROTATION_DIR "/app." + after + ".log"));
+}
+
+TEST_F(LoggerTests, TestFileIndex)
+{
+    const std::string logFile{ ROTATION_DIR "/app.log" };
+
+    {
+        pluto::Logger logger{};
+        logger.fileIndexInterval(10);
+
+        for (std::size_t i{ 0 }; i < 100; ++i)
+        {
+            logger.writef(logFile, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, "log message %zu", i);
+        }
+    }
+
+    std::vector<pluto::Logger::IndexEntry> entries{};
+    std::ifstream indexStream{ pluto::Logger::getIndexFilePath(logFile), std::ios_base::binary };
+    pluto::Logger::IndexEntry entry{};
+
+    while (indexStream.read(reinterpret_cast<char*>(&entry), sizeof(entry)))
+    {
+        entries.push_back(entry);
+    }
+
+    ASSERT_EQ(entries.size(), 10);
+
+    std::ifstream logStream{ logFile, std::ios_base::binary };
+    std::string log{};
+
+    for (std::size_t i{ 0 }; i < entries.size(); ++i)
+    {
+        ASSERT_TRUE(i == 0 || entries[i - 1].timestamp <= entries[i].timestamp);
+
+        logStream.seekg(static_cast<std::streamoff>(entries[i].offset));
+        std::getline(logStream, log);
+        ASSERT_EQ(log.substr(log.rfind(" | ") + 3), "log message " + std::to_string(i * 10));
+    }
+}
+
+TEST_F(LoggerTests, TestFileIndexOutOfOrder)
+{
+    const std::string logFile{ ROTATION_DIR "/app.log" };
+
+    std::tm localTime{};
+    localTime.tm_year = 2026 - 1900;
+    localTime.tm_mon = 9;
+    localTime.tm_mday = 17;
+    localTime.tm_hour = 13;
+    localTime.tm_isdst = -1;
+
+    const auto boundary{ pluto::Logger::Clock::from_time_t(std::mktime(&localTime)) };
+    const std::vector<pluto::Logger::Clock::time_point> timestamps{
+        boundary - std::chrono::seconds(2),
+        boundary + std::chrono::seconds(1),
+        boundary - std::chrono::seconds(1),
+        boundary + std::chrono::seconds(3),
+        boundary + std::chrono::seconds(2),
+        boundary + std::chrono::seconds(4) };
+
+    {
+        pluto::Logger logger{};
+        logger
+            .bufferFlushSize(1000)
+            .fileIndexInterval(1)
+            .fileRotationPeriod(pluto::Logger::FileRotationPeriod::Hourly);
+
+        for (std::size_t i{ 0 }; i < timestamps.size(); ++i)
+        {
+            logger.write(timestamps[i], logFile, pluto::Logger::Level::None, __FILE__, __LINE__, __func__,
+                "log message " + std::to_string(i));
+        }
+    }
+
+    const auto readIndex{ [](const std::string& filePath)
+        {
+            std::vector<pluto::Logger::IndexEntry> entries{};
+            std::ifstream indexStream{ pluto::Logger::getIndexFilePath(filePath), std::ios_base::binary };
+            pluto::Logger::IndexEntry entry{};
+
+            while (indexStream.read(reinterpret_cast<char*>(&entry), sizeof(entry)))
+            {
+                entries.push_back(entry);
+            }
+
+            return entries;
+        } };
+
+    // The log from before the boundary that came after one from after it stays in the later file
+    ASSERT_EQ(readIndex(ROTATION_DIR "/app.2026-10-17T12.log").size(), 1);
+
+    const auto entries{ readIndex(ROTATION_DIR "/app.2026-10-17T13.log") };
+    ASSERT_EQ(entries.size(), 5);
+
+    std::ifstream logStream{ ROTATION_DIR "/app.2026-10-17T13.log", std::ios_base::binary };
+    std::string log{};
+
+    for (std::size_t i{ 0 }; i < entries.size(); ++i)
+    {
+        ASSERT_TRUE(i == 0 || entries[i - 1].timestamp <= entries[i].timestamp);
+
+        logStream.seekg(static_cast<std::streamoff>(entries[i].offset));
+        std::getline(logStream, log);
+        ASSERT_EQ(log.substr(log.rfind(" | ") + 3), "log message " + std::to_string(i + 1));
+    }
+}
+
+TEST_F(LoggerTests, TestShutdownWritesRemainingLogs)
+{
+    auto sink{ std::make_shared<MemorySink>() };
+    std::size_t numRemaining{ 1 };
+
+    {
+        pluto::Logger logger{};
+        logger
+            .bufferFlushSize(1000)
+            .sink(LOG_FILE, sink)
+            .shutdownCallback([&](const std::size_t, const std::size_t remaining) { numRemaining = remaining; });
+
+        for (std::size_t i{ 0 }; i < 100; ++i)
+        {
+            logger.write(LOG_FILE, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, "log message");
+        }
+    }
+
+    ASSERT_EQ(sink->logs.size(), 100);
+    ASSERT_EQ(numRemaining, 0);
+}
+
+TEST_F(LoggerTests, TestBufferMaxBatchSize)
+{
+    auto sink{ std::make_shared<MemorySink>() };
+
+    {
+        pluto::Logger logger{};
+        logger
+            .bufferFlushSize(20)
+            .bufferMaxBatchSize(10)
+            .sink(LOG_FILE, sink);
+
+        for (std::size_t i{ 0 }; i < 95; ++i)
+        {
+            logger.write(LOG_FILE, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, "log message");
+        }
+    }
+
+    ASSERT_EQ(sink->logs.size(), 95);
+    ASSERT_LE(10, sink->numBatches);
+    ASSERT_EQ(sink->maxBatchSize, 10);
+}
+
+TEST_F(LoggerTests, TestWriterSettings)
+{
+    auto sink{ std::make_shared<MemorySink>() };
+
+    {
+        pluto::Logger logger{};
+        logger
+            .writerAffinity({ 0 })
+            .writerPriority(1)
+            .writerWakeDelay(20000)
+            .sink(LOG_FILE, sink);
+
+        ASSERT_EQ(logger.writerAffinity(), std::vector<std::size_t>{ 0 });
+        ASSERT_EQ(logger.writerPriority(), 1);
+        ASSERT_EQ(logger.writerWakeDelay(), 20000);
+
+        for (std::size_t i{ 0 }; i < 10; ++i)
+        {
+            logger.write(LOG_FILE, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, "log message");
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+
+    // Logs arriving within the wake delay are written together
+    ASSERT_EQ(sink->logs.size(), 10);
+    ASSERT_GT(10, sink->numBatches);
+}
+
+#ifdef __linux__
+TEST_F(LoggerTests, TestWriterKeepsInheritedSettings)
+{
+    int nice{ 0 };
+    int writerNice{ 0 };
+    int numWriterCPUs{ 0 };
+
+    // Writer threads inherit the affinity and priority of the thread that creates the logger
+    std::thread{ [&]()
+        {
+            const auto threadID{ static_cast<id_t>(syscall(SYS_gettid)) };
+
+            cpu_set_t cpus{};
+            pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+
+            cpu_set_t pinned{};
+            CPU_ZERO(&pinned);
+
+            for (int cpu{ 0 }; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &cpus))
+                {
+                    CPU_SET(cpu, &pinned);
+                    break;
+                }
+            }
+
+            pthread_setaffinity_np(pthread_self(), sizeof(pinned), &pinned);
+            setpriority(PRIO_PROCESS, threadID, getpriority(PRIO_PROCESS, threadID) + 1);
+            nice = getpriority(PRIO_PROCESS, threadID);
+
+            pluto::Logger logger{};
+            logger.route(LOG_FILE, pluto::Logger::Level::None,
+                [&](const pluto::Logger::Level, const std::string&)
+                {
+                    cpu_set_t writerCPUs{};
+                    pthread_getaffinity_np(pthread_self(), sizeof(writerCPUs), &writerCPUs);
+                    numWriterCPUs = CPU_COUNT(&writerCPUs);
+                    writerNice = getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)));
+                });
+
+            logger.write(LOG_FILE, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, "log message");
+        } }.join();
+
+    // Neither was set, so the writer left both alone
+    ASSERT_EQ(numWriterCPUs, 1);
+    ASSERT_EQ(writerNice, nice);
+}
+#endif
+
+TEST_F(LoggerTests, TestWriteAsync)
+{
+    pluto::Logger logger{};
+    logger
+        .writeHeader(false)
+        .bufferFlushSize(1000)
+        .level(LOG_FILE, pluto::Logger::Level::Info);
+
+    // Written without waiting for the flush size
+    auto future{ logger.writeAsync(LOG_FILE, pluto::Logger::Level::Info, __FILE__, __LINE__, __func__, "Async log message", true) };
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    ASSERT_TRUE(future.get());
+
+    std::ifstream logFile{ LOG_FILE };
+    std::string log{};
+    ASSERT_TRUE(std::getline(logFile, log));
+    ASSERT_NE(log.find("Async log message"), std::string::npos);
+
+    auto filteredFuture{ logger.writeAsync(LOG_FILE, pluto::Logger::Level::Debug, __FILE__, __LINE__, __func__, "Filtered log message") };
+    ASSERT_FALSE(filteredFuture.get());
+}
+
+TEST_F(LoggerTests, TestWriteAsyncBatch)
+{
+    auto sink{ std::make_shared<MemorySink>() };
+    std::vector<std::future<bool>> futures{};
+
+    {
+        pluto::Logger logger{};
+        logger
+            .writerWakeDelay(20000)
+            .sink(LOG_FILE, sink);
+
+        for (std::size_t i{ 0 }; i < 10; ++i)
+        {
+            futures.push_back(logger.writeAsync(LOG_FILE, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, "log message"));
+        }
+
+        for (auto& future : futures)
+        {
+            ASSERT_TRUE(future.get());
+        }
+    }
+
+    ASSERT_EQ(sink->logs.size(), 10);
+    ASSERT_GT(10, sink->numBatches);
+}
+
+#if PLUTO_LOGGER_HAS_COROUTINES
+struct DetachedTask
+{
+    struct promise_type
+    {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+DetachedTask writeAndWait(pluto::Logger& logger, std::promise<bool>& result)
+{
+    result.set_value(co_await logger.awaitWrite(LOG_FILE, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, "Awaited log message"));
+}
+
+TEST_F(LoggerTests, TestAwaitWrite)
+{
+    pluto::Logger logger{};
+    logger.bufferFlushSize(1000);
+
+    std::promise<bool> result{};
+    auto future{ result.get_future() };
+    writeAndWait(logger, result);
+
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    ASSERT_TRUE(future.get());
+}
+#endif
+
+// Blocks the writer until released
+class BlockingSink : public pluto::Logger::Sink
+{
+    std::mutex m_mutex{};
+    std::condition_variable m_condition{};
+    bool m_isBlocked{ false };
+    bool m_isReleased{ false };
+
+public:
+    bool write(const pluto::Logger::LogBatch&) override
+    {
+        std::unique_lock<std::mutex> lock{ m_mutex };
+        m_isBlocked = true;
+        m_condition.notify_all();
+        m_condition.wait(lock, [this]() { return m_isReleased; });
+        return true;
+    }
+
+    void waitUntilBlocked()
+    {
+        std::unique_lock<std::mutex> lock{ m_mutex };
+        m_condition.wait(lock, [this]() { return m_isBlocked; });
+    }
+
+    void release()
+    {
+        const std::unique_lock<std::mutex> lock{ m_mutex };
+        m_isReleased = true;
+        m_condition.notify_all();
+    }
+};
+
+TEST_F(LoggerTests, TestShutdownTimeout)
+{
+    auto sink{ std::make_shared<BlockingSink>() };
+    std::size_t numWritten{ 0 };
+    std::size_t numRemaining{ 0 };
+
+    auto destroyed{ std::async(std::launch::async, [&]()
+        {
+            pluto::Logger logger{};
+            logger
+                .sink(LOG_FILE, sink)
+                .route(LOG_FILE, pluto::Logger::Level::None, ROUTE_FILE)
+                .shutdownTimeout(100)
+                .shutdownSpillFile(SPILL_FILE)
+                .shutdownCallback([&](const std::size_t written, const std::size_t remaining)
+                    {
+                        numWritten = written;
+                        numRemaining = remaining;
+                    });
+
+            // The writer blocks in the sink with the first log while the rest queue up
+            logger.write(LOG_FILE, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, "log message");
+            sink->waitUntilBlocked();
+
+            for (std::size_t i{ 0 }; i < 9; ++i)
+            {
+                logger.write(LOG_FILE, pluto::Logger::Level::None, __FILE__, __LINE__, __func__, "spilled log message");
+            }
+        }) };
+
+    // The destructor returns without the sink, which then lets the detached writer go
+    const auto status{ destroyed.wait_for(std::chrono::seconds(10)) };
+    sink->release();
+
+    ASSERT_EQ(status, std::future_status::ready);
+    destroyed.get();
+
+    // The blocked log isn't known to be written
+    ASSERT_EQ(numWritten, 0);
+    ASSERT_EQ(numRemaining, 10);
+    ASSERT_EQ(countLogs(SPILL_FILE), 9);
+}
+
+#ifndef _WIN32
+TEST_F(LoggerTests, TestMappedFile)
+{
+    auto& logger{ pluto::Logger::getInstance() };
+
+    logger.fileMapSize(4096);
+    PLUTO_LOG_STREAM_INFO(MAPPED_FILE, "Mapped log message");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    logger.fileMapSize(0);
+
+    // The whole segment is preallocated
+    ASSERT_EQ(pluto::FileSystem::file_size(MAPPED_FILE), 4096);
+
+    std::ifstream logFile{ MAPPED_FILE };
+    const std::string contents{ std::istreambuf_iterator<char>{ logFile }, std::istreambuf_iterator<char>{} };
+    ASSERT_NE(contents.find("Mapped log message\n"), std::string::npos);
+}
+#endif
+
+TEST_F(LoggerTests, TestLevelPatterns)
+{
+    auto& logger{ pluto::Logger::getInstance() };
+
+    logger.level("test*.log", pluto::Logger::Level::Error);
+    ASSERT_EQ(logger.level(LOG_FILE), pluto::Logger::Level::Error);
+    ASSERT_EQ(logger.level(ROUTE_FILE), pluto::Logger::Level::Error);
+    ASSERT_EQ(logger.level("other.log"), logger.level());
+
+    // Exact names win over patterns and the same call sites must pick up each change
+    for (const auto level : { pluto::Logger::Level::Error, pluto::Logger::Level::Info })
+    {
+        logger.level(LOG_FILE, level);
+
+        LOG_STREAM_ERROR("Error log message");
+        LOG_STREAM_INFO("Info log message");
+        LOG_FORMAT_DEBUG("Debug log message");
+
+        ASSERT_EQ(getLastLogMessage(), ((level == pluto::Logger::Level::Error) ? "Error log message" : "Info log message"));
+    }
+
+    // Source file names can be matched too
+    logger.clearLevels();
+    logger.level("test*.log", pluto::Logger::Level::Error);
+    logger.level("logger_tests.cpp", pluto::Logger::Level::Verbose);
+    ASSERT_EQ(logger.level(LOG_FILE, __FILE__), pluto::Logger::Level::Verbose);
+
+    LOG_FORMAT_DEBUG("Debug log message");
+    ASSERT_EQ(getLastLogMessage(), "Debug log message");
+
+    logger.clearLevels();
+    ASSERT_EQ(logger.level(LOG_FILE), logger.level());
+}
+
+TEST_F(LoggerTests, TestCallSiteLogFiles)
+{
+    {
+        pluto::Logger logger{};
+        logger
+            .level(LOG_FILE, pluto::Logger::Level::Error)
+            .level(ROUTE_FILE, pluto::Logger::Level::Verbose);
+
+        // One call site logging to files with different levels
+        static pluto::Logger::CallSite callSite{};
+
+        for (const auto logFileName : { LOG_FILE, ROUTE_FILE, LOG_FILE, ROUTE_FILE })
+        {
+            logger.stream(callSite, logFileName, pluto::Logger::Level::Info, __FILE__, __LINE__, __func__)
+                << "Info log message";
+        }
+    }
+
+    ASSERT_EQ(countLogs(), 0);
+    ASSERT_EQ(countLogs(ROUTE_FILE), 4);    // +2 for header
+}
+
+TEST_F(LoggerTests, TestCallSiteLoggers)
+{
+    {
+        // The first file each logger logs to gets the same ID
+        pluto::Logger errorLogger{};
+        errorLogger.level(LOG_FILE, pluto::Logger::Level::Error);
+
+        pluto::Logger verboseLogger{};
+        verboseLogger.level(ROUTE_FILE, pluto::Logger::Level::Verbose);
+
+        static pluto::Logger::CallSite callSite{};
+
+        for (std::size_t i{ 0 }; i < 2; ++i)
+        {
+            errorLogger.stream(callSite, LOG_FILE, pluto::Logger::Level::Info, __FILE__, __LINE__, __func__)
+                << "Info log message";
+            verboseLogger.stream(callSite, ROUTE_FILE, pluto::Logger::Level::Info, __FILE__, __LINE__, __func__)
+                << "Info log message";
+        }
+    }
+
+    ASSERT_EQ(countLogs(), 0);
+    ASSERT_EQ(countLogs(ROUTE_FILE), 4);    // +2 for header
+}
+
+TEST_F(LoggerTests, TestThreadNames)
+{
+    const auto separator{ pluto::Logger::getInstance().separator() };
+
+    std::thread{ []()
+        {
+            pluto::Logger::setThreadName("io-3");
+            LOG_STREAM("Named log message");
+        } }.join();
+
+    ASSERT_NE(getLastLog().find(separator + "io-3  " + separator), std::string::npos);
+
+    LOG_STREAM("Unnamed log message");
+
+    auto threadID{ std::to_string(pluto::Logger::threadID()) };
+    threadID.resize(pluto::Logger::getInstance().threadIDLength(), ' ');
+
+    ASSERT_EQ(pluto::Logger::threadName(pluto::Logger::threadID()), std::to_string(pluto::Logger::threadID()));
+    ASSERT_NE(getLastLog().find(separator + threadID + separator), std::string::npos);
+
+    // Names of threads that exited a while ago are forgotten
+    std::vector<std::size_t> threadIDs{};
+
+    for (std::size_t i{ 0 }; i <= 256; ++i)
+    {
+        std::thread{ [&]()
+            {
+                pluto::Logger::setThreadName("worker");
+                threadIDs.push_back(pluto::Logger::threadID());
+            } }.join();
+    }
+
+    ASSERT_EQ(pluto::Logger::threadName(threadIDs.front()), std::to_string(threadIDs.front()));
+    ASSERT_EQ(pluto::Logger::threadName(threadIDs.back()), "worker");
+}
@@ -7,8 +7,17 @@
 
 #include "pluto/lru_cache.hpp"
 
+#include <cctype>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
 #include <gtest/gtest.h>
 
+#include "weighers.hpp"
+
 #define CACHE_CAPACITY 100
 
 class LRUCacheTests : public testing::Test
@@ -177,3 +186,624 @@ TEST_F(LRUCacheTests, TestRemove)
     std::size_t value{ 0 };
     ASSERT_FALSE(cache.get(1, value));
 }
+
+TEST_F(LRUCacheTests, TestCopyKeepsOrder)
+{
+    for (std::size_t i{ 1 }; i <= CACHE_CAPACITY; ++i)
+    {
+        cache.insert(i, i);
+    }
+
+    std::size_t value{ 0 };
+    cache.get(1, value);
+
+    auto copy{ cache };
+    copy.insert(CACHE_CAPACITY + 1, CACHE_CAPACITY + 1);
+
+    ASSERT_EQ(copy.size(), CACHE_CAPACITY);
+    ASSERT_TRUE(copy.get(1, value));
+    ASSERT_FALSE(copy.get(2, value));
+    ASSERT_TRUE(cache.get(2, value));
+
+    auto moved{ std::move(copy) };
+    ASSERT_EQ(moved.size(), CACHE_CAPACITY);
+    ASSERT_TRUE(moved.get(1, value));
+    ASSERT_TRUE(copy.empty());
+}
+
+struct CaseInsensitiveHash
+{
+    std::size_t operator()(const std::string& key) const
+    {
+        std::string lower{ key };
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](const char c) { return static_cast<char>(std::tolower(c)); });
+        return std::hash<std::string>{}(lower);
+    }
+};
+
+struct CaseInsensitiveEqual
+{
+    bool operator()(const std::string& lhs, const std::string& rhs) const
+    {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+            [](const char l, const char r) { return std::tolower(l) == std::tolower(r); });
+    }
+};
+
+TEST_F(LRUCacheTests, TestCustomHash)
+{
+    pluto::LRUCache<std::string, std::size_t, CaseInsensitiveHash, CaseInsensitiveEqual> stringCache{ CACHE_CAPACITY };
+
+    stringCache.insert("Key", 1);
+    stringCache.insert("KEY", 2);
+
+    std::size_t value{ 0 };
+    ASSERT_EQ(stringCache.size(), 1);
+    ASSERT_TRUE(stringCache.get("key", value));
+    ASSERT_EQ(value, 2);
+}
+
+TEST_F(LRUCacheTests, TestManyEntries)
+{
+    const std::size_t numEntries{ 10000 };
+    pluto::LRUCache<std::size_t, std::size_t> largeCache{ numEntries };
+
+    // Keys differing only in their high bits still spread across buckets
+    for (std::size_t i{ 0 }; i < numEntries; ++i)
+    {
+        largeCache.insert(i << 20, i);
+    }
+
+    for (std::size_t i{ 0 }; i < numEntries; i += 2)
+    {
+        ASSERT_TRUE(largeCache.remove(i << 20));
+    }
+
+    ASSERT_EQ(largeCache.size(), numEntries / 2);
+
+    std::size_t value{ 0 };
+    for (std::size_t i{ 0 }; i < numEntries; ++i)
+    {
+        ASSERT_EQ(largeCache.get(i << 20, value), (i % 2) == 1);
+    }
+}
+
+TEST_F(LRUCacheTests, TestPreallocate)
+{
+    pluto::LRUCache<std::string, std::string> stringCache{ CACHE_CAPACITY, true };
+
+    // Evicted nodes are reused for the entries replacing them
+    for (std::size_t i{ 0 }; i < (CACHE_CAPACITY * 3); ++i)
+    {
+        stringCache.insert(std::to_string(i), "value " + std::to_string(i));
+    }
+
+    ASSERT_EQ(stringCache.size(), CACHE_CAPACITY);
+
+    stringCache.capacity(CACHE_CAPACITY * 2);
+    for (std::size_t i{ 0 }; i < CACHE_CAPACITY; ++i)
+    {
+        stringCache.insert("new " + std::to_string(i), "new value");
+    }
+
+    ASSERT_EQ(stringCache.size(), CACHE_CAPACITY * 2);
+
+    std::string value{};
+    ASSERT_FALSE(stringCache.get(std::to_string(CACHE_CAPACITY * 2 - 1), value));
+    ASSERT_TRUE(stringCache.get(std::to_string(CACHE_CAPACITY * 2), value));
+    ASSERT_EQ(value, "value " + std::to_string(CACHE_CAPACITY * 2));
+
+    // Removed nodes are reused too
+    ASSERT_TRUE(stringCache.remove("new 0"));
+    stringCache.insert("new 0", "newer value");
+    ASSERT_TRUE(stringCache.get("new 0", value));
+    ASSERT_EQ(value, "newer value");
+}
+
+TEST_F(LRUCacheTests, TestGetInPlaceAndEvict)
+{
+    ASSERT_EQ(cache.get(1), nullptr);
+    ASSERT_EQ(cache.nextEvicted(), nullptr);
+    ASSERT_FALSE(cache.evict());
+
+    for (std::size_t i{ 1 }; i <= CACHE_CAPACITY; ++i)
+    {
+        cache.insert(i, i);
+    }
+
+    ASSERT_EQ(*cache.nextEvicted(), 1);
+
+    // Updating in place also moves the entry to the front
+    const auto value{ cache.get(1) };
+    ASSERT_NE(value, nullptr);
+    *value = 10;
+    ASSERT_EQ(*cache.nextEvicted(), 2);
+
+    ASSERT_TRUE(cache.evict());
+    ASSERT_EQ(cache.size(), CACHE_CAPACITY - 1);
+    ASSERT_FALSE(cache.contains(2));
+    ASSERT_EQ(*cache.get(1), 10);
+}
+
+TEST_F(LRUCacheTests, TestClockPolicy)
+{
+    pluto::LRUCache<std::size_t, std::size_t, std::hash<std::size_t>, std::equal_to<std::size_t>, pluto::ClockPolicy> clockCache{ CACHE_CAPACITY };
+    ASSERT_TRUE(clockCache.concurrentHits());
+    ASSERT_FALSE(cache.concurrentHits());
+
+    for (std::size_t i{ 1 }; i <= CACHE_CAPACITY; ++i)
+    {
+        clockCache.insert(i, i);
+    }
+
+    // Referenced entries get a second chance, the hand evicts the first one that wasn't
+    std::size_t value{ 0 };
+    ASSERT_TRUE(clockCache.get(1, value));
+    ASSERT_TRUE(clockCache.get(3, value));
+    ASSERT_EQ(*clockCache.nextEvicted(), 2);
+
+    clockCache.insert(CACHE_CAPACITY + 1, CACHE_CAPACITY + 1);
+    clockCache.insert(CACHE_CAPACITY + 2, CACHE_CAPACITY + 2);
+
+    ASSERT_EQ(clockCache.size(), CACHE_CAPACITY);
+    ASSERT_TRUE(clockCache.contains(1));
+    ASSERT_FALSE(clockCache.contains(2));
+    ASSERT_TRUE(clockCache.contains(3));
+    ASSERT_FALSE(clockCache.contains(4));
+    ASSERT_TRUE(clockCache.contains(CACHE_CAPACITY + 2));
+
+    ASSERT_TRUE(clockCache.remove(CACHE_CAPACITY + 1));
+    ASSERT_EQ(clockCache.size(), CACHE_CAPACITY - 1);
+}
+
+TEST_F(LRUCacheTests, TestClockProPolicyResistsScans)
+{
+    pluto::LRUCache<std::size_t, std::size_t, std::hash<std::size_t>, std::equal_to<std::size_t>, pluto::ClockProPolicy> clockProCache{ CACHE_CAPACITY };
+    const std::size_t workingSetSize{ CACHE_CAPACITY / 2 };
+
+    // The working set is used twice, then keys used once scan past it
+    std::size_t nextScanKey{ CACHE_CAPACITY * 10 };
+    std::size_t numHits{ 0 };
+    std::size_t numLRUHits{ 0 };
+
+    for (std::size_t round{ 0 }; round < 20; ++round)
+    {
+        for (std::size_t i{ 0 }; i < (workingSetSize * 2); ++i)
+        {
+            const auto key{ i % workingSetSize };
+            std::size_t value{ 0 };
+
+            if (clockProCache.get(key, value))
+            {
+                ++numHits;
+                ASSERT_EQ(value, key);
+            }
+            else
+            {
+                clockProCache.insert(key, key);
+            }
+
+            if (cache.get(key, value))
+            {
+                ++numLRUHits;
+            }
+            else
+            {
+                cache.insert(key, key);
+            }
+        }
+
+        for (std::size_t i{ 0 }; i < CACHE_CAPACITY; ++i, ++nextScanKey)
+        {
+            clockProCache.insert(nextScanKey, nextScanKey);
+            cache.insert(nextScanKey, nextScanKey);
+        }
+
+        ASSERT_EQ(clockProCache.size(), CACHE_CAPACITY);
+    }
+
+    // A scan as big as the cache flushes LRU, CLOCK-Pro keeps most of the working set
+    ASSERT_LT(numLRUHits, numHits);
+    ASSERT_LT(workingSetSize * 20, numHits);
+
+    std::size_t numCached{ 0 };
+    for (std::size_t key{ 0 }; key < workingSetSize; ++key)
+    {
+        numCached += clockProCache.contains(key) ? 1 : 0;
+    }
+
+    ASSERT_LT(workingSetSize / 2, numCached);
+}
+
+template<class PolicyT>
+void testPolicyAgainstMap(const std::size_t capacity)
+{
+    pluto::LRUCache<std::size_t, std::string, std::hash<std::size_t>, std::equal_to<std::size_t>, PolicyT> policyCache{ capacity };
+    std::unordered_map<std::size_t, std::string> latest{};
+    std::mt19937 random{ 42 };
+
+    for (std::size_t i{ 0 }; i < 20000; ++i)
+    {
+        const std::size_t key{ random() % (capacity * 3) };
+        const auto operation{ random() % 10 };
+        std::string value{};
+
+        if (operation < 5)
+        {
+            if (policyCache.get(key, value))
+            {
+                ASSERT_EQ(value, latest[key]);
+            }
+        }
+        else if (operation < 9)
+        {
+            latest[key] = "value " + std::to_string(i) + " for key " + std::to_string(key);
+            policyCache.insert(key, latest[key]);
+            ASSERT_TRUE(policyCache.contains(key));
+        }
+        else
+        {
+            policyCache.remove(key);
+            ASSERT_FALSE(policyCache.contains(key));
+        }
+
+        ASSERT_LE(policyCache.size(), capacity);
+
+        if (i == 10000)
+        {
+            policyCache.capacity(capacity / 2);
+            ASSERT_LE(policyCache.size(), capacity / 2);
+            policyCache.capacity(capacity);
+        }
+    }
+
+    // Copies and moves keep every entry
+    auto copy{ policyCache };
+    ASSERT_EQ(copy.size(), policyCache.size());
+
+    auto moved{ std::move(copy) };
+    ASSERT_EQ(moved.size(), policyCache.size());
+    ASSERT_TRUE(copy.empty());
+
+    for (std::size_t key{ 0 }; key < (capacity * 3); ++key)
+    {
+        std::string value{};
+        ASSERT_EQ(moved.get(key, value), policyCache.contains(key));
+    }
+}
+
+TEST_F(LRUCacheTests, TestPoliciesAgainstMap)
+{
+    testPolicyAgainstMap<pluto::LRUPolicy>(CACHE_CAPACITY);
+    testPolicyAgainstMap<pluto::ClockPolicy>(CACHE_CAPACITY);
+    testPolicyAgainstMap<pluto::ClockProPolicy>(CACHE_CAPACITY);
+    testPolicyAgainstMap<pluto::TinyLFUPolicy>(CACHE_CAPACITY);
+    testPolicyAgainstMap<pluto::TinyLFUPolicy>(1);
+    testPolicyAgainstMap<pluto::ARCPolicy>(CACHE_CAPACITY);
+    testPolicyAgainstMap<pluto::ARCPolicy>(1);
+    testPolicyAgainstMap<pluto::TwoQueuePolicy>(CACHE_CAPACITY);
+    testPolicyAgainstMap<pluto::TwoQueuePolicy>(1);
+}
+
+TEST_F(LRUCacheTests, TestFrequencySketch)
+{
+    pluto::FrequencySketch sketch{};
+    ASSERT_EQ(sketch.frequency(1), 0);
+
+    sketch.capacity(CACHE_CAPACITY);
+    for (std::size_t i{ 0 }; i < 5; ++i)
+    {
+        sketch.increment(1);
+    }
+
+    for (std::size_t i{ 0 }; i < 100; ++i)
+    {
+        sketch.increment(2);
+    }
+
+    ASSERT_EQ(sketch.frequency(1), 5);
+    ASSERT_EQ(sketch.frequency(2), pluto::FrequencySketch::maxFrequency());
+    ASSERT_EQ(sketch.frequency(3), 0);
+
+    // Enough increments halve every counter
+    for (std::size_t i{ 0 }; i < (CACHE_CAPACITY * 10); ++i)
+    {
+        sketch.increment(1000 + i);
+    }
+
+    ASSERT_LE(sketch.frequency(1), 3);
+    ASSERT_LE(sketch.frequency(2), 8);
+}
+
+TEST_F(LRUCacheTests, TestTinyLFUPolicyResistsScans)
+{
+    pluto::LRUCache<std::size_t, std::size_t, std::hash<std::size_t>, std::equal_to<std::size_t>, pluto::TinyLFUPolicy> tinyLFUCache{ CACHE_CAPACITY };
+    const std::size_t workingSetSize{ CACHE_CAPACITY / 2 };
+    std::size_t nextScanKey{ CACHE_CAPACITY * 10 };
+
+    for (std::size_t round{ 0 }; round < 20; ++round)
+    {
+        for (std::size_t key{ 0 }; key < workingSetSize; ++key)
+        {
+            std::size_t value{ 0 };
+            if (!tinyLFUCache.get(key, value))
+            {
+                tinyLFUCache.insert(key, key);
+            }
+        }
+
+        for (std::size_t i{ 0 }; i < (CACHE_CAPACITY * 2); ++i, ++nextScanKey)
+        {
+            tinyLFUCache.insert(nextScanKey, nextScanKey);
+        }
+
+        ASSERT_EQ(tinyLFUCache.size(), CACHE_CAPACITY);
+    }
+
+    // Scans twice the size of the cache only churn the window and the spare room
+    for (std::size_t key{ 0 }; key < workingSetSize; ++key)
+    {
+        ASSERT_TRUE(tinyLFUCache.contains(key));
+    }
+}
+
+// A working set that fits is used twice, then a scan the size of the cache passes through
+template<class PolicyT>
+std::size_t countWorkingSetHits(const std::size_t capacity, const std::size_t numRounds)
+{
+    pluto::LRUCache<std::size_t, std::size_t, std::hash<std::size_t>, std::equal_to<std::size_t>, PolicyT> policyCache{ capacity };
+    std::size_t nextScanKey{ capacity * 10 };
+    std::size_t numHits{ 0 };
+
+    for (std::size_t round{ 0 }; round < numRounds; ++round)
+    {
+        for (std::size_t pass{ 0 }; pass < 2; ++pass)
+        {
+            for (std::size_t key{ 0 }; key < (capacity / 2); ++key)
+            {
+                std::size_t value{ 0 };
+                if (policyCache.get(key, value))
+                {
+                    ++numHits;
+                }
+                else
+                {
+                    policyCache.insert(key, key);
+                }
+            }
+        }
+
+        for (std::size_t i{ 0 }; i < capacity; ++i, ++nextScanKey)
+        {
+            policyCache.insert(nextScanKey, nextScanKey);
+        }
+    }
+
+    return numHits;
+}
+
+TEST_F(LRUCacheTests, TestAdaptivePoliciesResistScans)
+{
+    const std::size_t numRounds{ 20 };
+    const auto lruHits{ countWorkingSetHits<pluto::LRUPolicy>(CACHE_CAPACITY, numRounds) };
+    const auto arcHits{ countWorkingSetHits<pluto::ARCPolicy>(CACHE_CAPACITY, numRounds) };
+    const auto twoQueueHits{ countWorkingSetHits<pluto::TwoQueuePolicy>(CACHE_CAPACITY, numRounds) };
+
+    // LRU loses the working set to every scan, so only the second pass of each round hits
+    ASSERT_EQ(lruHits, numRounds * (CACHE_CAPACITY / 2));
+
+    // Keys used twice are kept apart from keys used once, so after the first round both passes hit
+    ASSERT_GE(arcHits, ((2 * numRounds) - 3) * (CACHE_CAPACITY / 2));
+    ASSERT_GE(twoQueueHits, ((2 * numRounds) - 3) * (CACHE_CAPACITY / 2));
+}
+
+// Only moves when a test moves it
+struct ManualClock
+{
+    typedef std::chrono::nanoseconds duration;
+    typedef duration::rep rep;
+    typedef duration::period period;
+    typedef std::chrono::time_point<ManualClock> time_point;
+
+    static constexpr bool is_steady{ true };
+    static duration elapsed;
+
+    static time_point now() { return time_point{ elapsed }; }
+};
+
+ManualClock::duration ManualClock::elapsed{ 0 };
+
+typedef pluto::LRUCache<std::size_t, std::size_t, std::hash<std::size_t>, std::equal_to<std::size_t>,
+    pluto::LRUPolicy, pluto::TimerWheelExpiry<ManualClock>> ExpiringLRUCache;
+
+TEST_F(LRUCacheTests, TestExpiry)
+{
+    ManualClock::elapsed = std::chrono::hours(1);
+
+    ExpiringLRUCache expiringCache{ CACHE_CAPACITY };
+    ASSERT_EQ(expiringCache.timeToLive(), std::chrono::nanoseconds(0));
+
+    expiringCache.insert(1, 1);
+    expiringCache.insert(2, 2, std::chrono::milliseconds(10));
+    expiringCache.timeToLive(std::chrono::milliseconds(20));
+    expiringCache.insert(3, 3);
+
+    ManualClock::elapsed += std::chrono::milliseconds(10);
+
+    // Expired entries are misses as soon as they expire, even before they're reclaimed
+    std::size_t value{ 0 };
+    ASSERT_EQ(expiringCache.size(), 3);
+    ASSERT_FALSE(expiringCache.contains(2));
+    ASSERT_EQ(expiringCache.peek(2), nullptr);
+    ASSERT_FALSE(expiringCache.get(2, value));
+    ASSERT_EQ(expiringCache.size(), 2);
+    ASSERT_TRUE(expiringCache.get(3, value));
+
+    // Inserting again replaces the time to live
+    expiringCache.insert(3, 3, std::chrono::milliseconds(100));
+    ManualClock::elapsed += std::chrono::milliseconds(50);
+
+    ASSERT_EQ(expiringCache.expire(), 0);
+    ASSERT_TRUE(expiringCache.contains(1));
+    ASSERT_TRUE(expiringCache.contains(3));
+
+    ManualClock::elapsed += std::chrono::hours(24);
+
+    ASSERT_TRUE(expiringCache.contains(1));
+    ASSERT_FALSE(expiringCache.remove(3));
+    ASSERT_EQ(expiringCache.size(), 1);
+}
+
+TEST_F(LRUCacheTests, TestExpireAfterAccess)
+{
+    ManualClock::elapsed = std::chrono::hours(1);
+
+    ExpiringLRUCache expiringCache{ CACHE_CAPACITY };
+    expiringCache.timeToLive(std::chrono::milliseconds(10));
+    expiringCache.expireAfterAccess(true);
+    ASSERT_TRUE(expiringCache.expireAfterAccess());
+
+    expiringCache.insert(1, 1);
+    expiringCache.insert(2, 2);
+
+    // Hits keep the first entry alive well past its time to live, the second isn't used
+    for (std::size_t i{ 0 }; i < 20; ++i)
+    {
+        ManualClock::elapsed += std::chrono::milliseconds(5);
+        ASSERT_TRUE(expiringCache.touch(1));
+    }
+
+    ASSERT_EQ(expiringCache.size(), 1);
+    ASSERT_FALSE(expiringCache.contains(2));
+
+    // Peeking isn't a use
+    ManualClock::elapsed += std::chrono::milliseconds(5);
+    ASSERT_NE(expiringCache.peek(1), nullptr);
+    ManualClock::elapsed += std::chrono::milliseconds(5);
+    ASSERT_EQ(expiringCache.peek(1), nullptr);
+
+    ManualClock::elapsed += std::chrono::milliseconds(5);
+    ASSERT_EQ(expiringCache.expire(), 1);
+    ASSERT_TRUE(expiringCache.empty());
+}
+
+TEST_F(LRUCacheTests, TestExpiryKeptByCopies)
+{
+    ManualClock::elapsed = std::chrono::hours(1);
+
+    ExpiringLRUCache expiringCache{ CACHE_CAPACITY };
+    expiringCache.insert(1, 1, std::chrono::milliseconds(10));
+    expiringCache.insert(2, 2);
+
+    auto copy{ expiringCache };
+    auto moved{ std::move(expiringCache) };
+
+    ManualClock::elapsed += std::chrono::milliseconds(10);
+    ASSERT_FALSE(copy.contains(1));
+    ASSERT_FALSE(moved.contains(1));
+
+    // Reclaimed once the wheel passes the bucket after their expiry
+    ManualClock::elapsed += std::chrono::milliseconds(2);
+    ASSERT_EQ(copy.expire() + moved.expire(), 2);
+    ASSERT_EQ(copy.size(), 1);
+    ASSERT_EQ(moved.size(), 1);
+    ASSERT_TRUE(copy.contains(2));
+    ASSERT_TRUE(moved.contains(2));
+}
+
+// Random times to live from a millisecond to days, with the clock moving in small steps and large jumps
+TEST_F(LRUCacheTests, TestTimerWheelReclaimsExpiredEntries)
+{
+    const std::size_t numEntries{ 2000 };
+    const auto slack{ std::chrono::milliseconds(3) };   // Entries are reclaimed in the millisecond or so after expiring
+    std::vector<ManualClock::duration> expiries(numEntries);
+    std::mt19937_64 generator{ 7 };
+    std::uniform_int_distribution<int> exponent{ 20, 48 };
+
+    ManualClock::elapsed = std::chrono::hours(1);
+
+    ExpiringLRUCache expiringCache{ numEntries };
+    for (std::size_t i{ 0 }; i < numEntries; ++i)
+    {
+        const ManualClock::duration timeToLive{ (std::int64_t{ 1 } << exponent(generator)) + static_cast<std::int64_t>(generator() % 1000000) };
+        expiries[i] = ManualClock::elapsed + timeToLive;
+        expiringCache.insert(i, i, timeToLive);
+    }
+
+    ASSERT_EQ(expiringCache.size(), numEntries);
+
+    for (std::size_t step{ 0 }; !expiringCache.empty(); ++step)
+    {
+        ASSERT_LT(step, 10000);
+        ManualClock::elapsed += ManualClock::duration{ static_cast<std::int64_t>(generator() % (std::int64_t{ 1 } << ((step % 4 == 0) ? 44 : 22))) };
+        expiringCache.expire();
+
+        std::size_t numUnexpired{ 0 };
+        std::size_t numDue{ 0 };
+        for (std::size_t i{ 0 }; i < numEntries; ++i)
+        {
+            numUnexpired += (ManualClock::elapsed < expiries[i]) ? 1 : 0;
+            numDue += (expiries[i] + slack <= ManualClock::elapsed) ? 1 : 0;
+            ASSERT_EQ(expiringCache.contains(i), (ManualClock::elapsed < expiries[i]));
+        }
+
+        ASSERT_GE(expiringCache.size(), numUnexpired);
+        ASSERT_LE(expiringCache.size(), numEntries - numDue);
+    }
+}
+
+TEST_F(LRUCacheTests, TestWeightedCapacity)
+{
+    pluto::LRUCache<std::size_t, std::string, std::hash<std::size_t>, std::equal_to<std::size_t>,
+        pluto::LRUPolicy, pluto::NoExpiry, LengthWeigher> weightedCache{ CACHE_CAPACITY, true };
+
+    for (std::size_t i{ 0 }; i < 10; ++i)
+    {
+        ASSERT_TRUE(weightedCache.insert(i, std::string(10, 'a')));
+    }
+
+    ASSERT_EQ(weightedCache.size(), 10);
+    ASSERT_EQ(weightedCache.weight(), CACHE_CAPACITY);
+
+    // Evicts the three oldest entries to make room
+    ASSERT_TRUE(weightedCache.insert(10, std::string(25, 'b')));
+    ASSERT_EQ(weightedCache.size(), 8);
+    ASSERT_EQ(weightedCache.weight(), 95);
+    ASSERT_FALSE(weightedCache.contains(2));
+    ASSERT_TRUE(weightedCache.contains(3));
+
+    // Too heavy to ever fit, nothing is evicted for it
+    ASSERT_FALSE(weightedCache.insert(11, std::string(CACHE_CAPACITY + 1, 'c')));
+    ASSERT_EQ(weightedCache.size(), 8);
+    ASSERT_FALSE(weightedCache.contains(11));
+
+    // A heavier value pushes out older entries, one too heavy removes the old value
+    ASSERT_TRUE(weightedCache.insert(3, std::string(30, 'd')));
+    ASSERT_EQ(weightedCache.weight(), 95);
+    ASSERT_FALSE(weightedCache.contains(4));
+    ASSERT_FALSE(weightedCache.contains(5));
+    ASSERT_TRUE(weightedCache.contains(6));
+
+    ASSERT_FALSE(weightedCache.insert(3, std::string(CACHE_CAPACITY + 1, 'e')));
+    ASSERT_FALSE(weightedCache.contains(3));
+    ASSERT_EQ(weightedCache.weight(), 65);
+
+    // Values updated in place keep the weight they were inserted with
+    weightedCache.get(10)->clear();
+    ASSERT_EQ(weightedCache.weight(), 65);
+    ASSERT_TRUE(weightedCache.remove(10));
+    ASSERT_EQ(weightedCache.weight(), 40);
+
+    weightedCache.capacity(25);
+    ASSERT_EQ(weightedCache.size(), 2);
+    ASSERT_EQ(weightedCache.weight(), 20);
+
+    auto copy{ weightedCache };
+    ASSERT_EQ(copy.weight(), 20);
+    ASSERT_TRUE(copy.insert(20, std::string(10, 'f')));
+    ASSERT_EQ(copy.size(), 2);
+
+    weightedCache.clear();
+    ASSERT_EQ(weightedCache.weight(), 0);
+    ASSERT_FALSE(weightedCache.insert(1, std::string(26, 'g')));
+}
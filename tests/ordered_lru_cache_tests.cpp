@@ -0,0 +1,97 @@
+/*
+* Copyright (c) 2024 Stephen O Driscoll
+*
+* Distributed under the MIT License (See accompanying file LICENSE)
+* Official repository: https://github.com/Stephen-ODriscoll/PlutoUtils
+*/
+
+#include "pluto/ordered_lru_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#define ORDERED_CACHE_CAPACITY 100
+
+class OrderedLRUCacheTests : public testing::Test
+{
+public:
+    pluto::OrderedLRUCache<std::size_t, std::size_t> cache{ ORDERED_CACHE_CAPACITY };
+
+protected:
+    OrderedLRUCacheTests() {}
+    ~OrderedLRUCacheTests() {}
+
+    void TearDown() override
+    {
+        cache.clear();
+    }
+};
+
+// Ordered with operator<, with no std::hash or operator==
+struct OrderedKey
+{
+    int id;
+
+    bool operator<(const OrderedKey& other) const { return (id < other.id); }
+};
+
+TEST_F(OrderedLRUCacheTests, TestCacheSanity)
+{
+    std::size_t value{ 0 };
+
+    ASSERT_EQ(cache.size(), 0);
+    ASSERT_EQ(cache.capacity(), ORDERED_CACHE_CAPACITY);
+    ASSERT_TRUE(cache.empty());
+    ASSERT_FALSE(cache.contains(1));
+    ASSERT_FALSE(cache.get(1, value));
+
+    cache.insert(1, 1);
+
+    ASSERT_EQ(cache.size(), 1);
+    ASSERT_FALSE(cache.empty());
+    ASSERT_TRUE(cache.contains(1));
+    ASSERT_TRUE(cache.get(1, value));
+    ASSERT_EQ(value, 1);
+
+    ASSERT_TRUE(cache.remove(1));
+    ASSERT_FALSE(cache.remove(1));
+    ASSERT_TRUE(cache.empty());
+}
+
+TEST_F(OrderedLRUCacheTests, TestInsertEvictsLeastRecentlyUsed)
+{
+    for (std::size_t i{ 1 }; i <= ORDERED_CACHE_CAPACITY; ++i)
+    {
+        cache.insert(i, i);
+    }
+
+    std::size_t value{ 0 };
+    ASSERT_TRUE(cache.get(1, value));
+
+    cache.insert(ORDERED_CACHE_CAPACITY + 1, ORDERED_CACHE_CAPACITY + 1);
+
+    ASSERT_EQ(cache.size(), ORDERED_CACHE_CAPACITY);
+    ASSERT_TRUE(cache.contains(1));
+    ASSERT_FALSE(cache.contains(2));
+
+    cache.capacity(ORDERED_CACHE_CAPACITY / 2);
+    ASSERT_EQ(cache.size(), ORDERED_CACHE_CAPACITY / 2);
+    ASSERT_TRUE(cache.contains(1));
+    ASSERT_FALSE(cache.contains(ORDERED_CACHE_CAPACITY / 2));
+}
+
+TEST_F(OrderedLRUCacheTests, TestOrderedKeys)
+{
+    pluto::OrderedLRUCache<OrderedKey, std::string> orderedCache{ 2 };
+    std::string value{};
+
+    orderedCache.insert(OrderedKey{ 1 }, "one");
+    orderedCache.insert(OrderedKey{ 2 }, "two");
+    orderedCache.insert(OrderedKey{ 3 }, "three");
+
+    ASSERT_FALSE(orderedCache.contains(OrderedKey{ 1 }));
+    ASSERT_TRUE(orderedCache.get(OrderedKey{ 3 }, value));
+    ASSERT_EQ(value, "three");
+
+    static_assert(std::is_same<decltype(orderedCache)::ListType, std::list<OrderedKey>>::value,
+        "ListType is the list of keys");
+}
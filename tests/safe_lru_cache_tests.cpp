@@ -9,12 +9,16 @@
 
 #include <gtest/gtest.h>
 
+#include <thread>
+#include <vector>
+
 #define SAFE_CACHE_CAPACITY 100
 
 class SafeLRUCacheTests : public testing::Test
 {
 public:
     pluto::SafeLRUCache<std::size_t, std::size_t> safeCache{ SAFE_CACHE_CAPACITY };
+    pluto::SafeLRUCache<std::size_t, std::size_t> bufferedCache{ SAFE_CACHE_CAPACITY, pluto::SafeLRUCacheReads::Buffered };
 
 protected:
     SafeLRUCacheTests() {}
@@ -23,6 +27,7 @@ protected:
     void TearDown() override
     {
         safeCache.clear();
+        bufferedCache.clear();
     }
 };
 
@@ -177,3 +182,79 @@ TEST_F(SafeLRUCacheTests, TestRemove)
     std::size_t value{ 0 };
     ASSERT_FALSE(safeCache.get(1, value));
 }
+
+TEST_F(SafeLRUCacheTests, TestBufferedReadsMoveToFront)
+{
+    ASSERT_FALSE(safeCache.bufferReads());
+    ASSERT_TRUE(bufferedCache.bufferReads());
+
+    for (std::size_t i{ 1 }; i <= SAFE_CACHE_CAPACITY; ++i)
+    {
+        bufferedCache.insert(i, i);
+    }
+
+    // The hit is applied before the insert evicts
+    std::size_t value{ 0 };
+    ASSERT_TRUE(bufferedCache.get(1, value));
+    ASSERT_EQ(value, 1);
+    ASSERT_FALSE(bufferedCache.get(SAFE_CACHE_CAPACITY + 1, value));
+
+    bufferedCache.insert(SAFE_CACHE_CAPACITY + 1, SAFE_CACHE_CAPACITY + 1);
+
+    ASSERT_EQ(bufferedCache.size(), SAFE_CACHE_CAPACITY);
+    ASSERT_TRUE(bufferedCache.contains(1));
+    ASSERT_FALSE(bufferedCache.contains(2));
+
+    // Enough hits to fill a buffer are applied without waiting for an insert
+    for (std::size_t i{ 3 }; i <= SAFE_CACHE_CAPACITY; ++i)
+    {
+        ASSERT_TRUE(bufferedCache.get(i, value));
+        ASSERT_EQ(value, i);
+    }
+
+    // A removed entry that's still buffered is skipped
+    ASSERT_TRUE(bufferedCache.remove(SAFE_CACHE_CAPACITY));
+    bufferedCache.insert(SAFE_CACHE_CAPACITY + 2, SAFE_CACHE_CAPACITY + 2);
+    bufferedCache.insert(SAFE_CACHE_CAPACITY + 3, SAFE_CACHE_CAPACITY + 3);
+
+    ASSERT_EQ(bufferedCache.size(), SAFE_CACHE_CAPACITY);
+    ASSERT_FALSE(bufferedCache.contains(1));
+    ASSERT_TRUE(bufferedCache.contains(3));
+}
+
+TEST_F(SafeLRUCacheTests, TestBufferedReadsConcurrent)
+{
+    for (std::size_t i{ 0 }; i < SAFE_CACHE_CAPACITY; ++i)
+    {
+        bufferedCache.insert(i, i);
+    }
+
+    std::vector<std::thread> threads{};
+    for (std::size_t t{ 0 }; t < 4; ++t)
+    {
+        threads.emplace_back([this, t]()
+        {
+            for (std::size_t i{ 0 }; i < 10000; ++i)
+            {
+                const auto key{ (i * (t + 1)) % (SAFE_CACHE_CAPACITY * 2) };
+
+                std::size_t value{ 0 };
+                if (bufferedCache.get(key, value))
+                {
+                    ASSERT_EQ(value, key);
+                }
+                else if ((i % 4) == 0)
+                {
+                    bufferedCache.insert(key, key);
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(bufferedCache.size(), SAFE_CACHE_CAPACITY);
+}
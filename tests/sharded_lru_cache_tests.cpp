@@ -0,0 +1,258 @@
+/*
+* Copyright (c) 2024 Stephen O Driscoll
+*
+* Distributed under the MIT License (See accompanying file LICENSE)
+* Official repository: https://github.com/Stephen-ODriscoll/PlutoUtils
+*/
+
+#include "pluto/sharded_lru_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "weighers.hpp"
+
+#define SHARDED_CACHE_CAPACITY 100
+#define SHARDED_CACHE_SHARDS 4
+
+class ShardedLRUCacheTests : public testing::Test
+{
+public:
+    pluto::ShardedLRUCache<std::size_t, std::size_t, SHARDED_CACHE_SHARDS> shardedCache{ SHARDED_CACHE_CAPACITY };
+
+    // Samples every shard when evicting, so it behaves like one LRU cache
+    pluto::ShardedLRUCache<std::size_t, std::size_t, SHARDED_CACHE_SHARDS> globalCache{ SHARDED_CACHE_CAPACITY, false, true };
+
+protected:
+    ShardedLRUCacheTests() {}
+    ~ShardedLRUCacheTests() {}
+
+    void TearDown() override
+    {
+        shardedCache.clear();
+        globalCache.clear();
+    }
+};
+
+TEST_F(ShardedLRUCacheTests, TestCacheSanity)
+{
+    std::size_t value{ 0 };
+
+    ASSERT_EQ(shardedCache.shards(), SHARDED_CACHE_SHARDS);
+    ASSERT_FALSE(shardedCache.approximateGlobalLRU());
+    ASSERT_EQ(shardedCache.size(), 0);
+    ASSERT_EQ(shardedCache.capacity(), SHARDED_CACHE_CAPACITY);
+    ASSERT_TRUE(shardedCache.empty());
+    ASSERT_FALSE(shardedCache.contains(1));
+    ASSERT_FALSE(shardedCache.get(1, value));
+
+    shardedCache.insert(1, 1);
+
+    ASSERT_EQ(shardedCache.size(), 1);
+    ASSERT_FALSE(shardedCache.empty());
+    ASSERT_TRUE(shardedCache.contains(1));
+    ASSERT_TRUE(shardedCache.get(1, value));
+    ASSERT_EQ(value, 1);
+
+    ASSERT_TRUE(shardedCache.remove(1));
+    ASSERT_FALSE(shardedCache.remove(1));
+    ASSERT_TRUE(shardedCache.empty());
+
+    shardedCache.insert(1, 1);
+    shardedCache.clear();
+
+    ASSERT_EQ(shardedCache.size(), 0);
+    ASSERT_EQ(shardedCache.capacity(), SHARDED_CACHE_CAPACITY);
+    ASSERT_TRUE(shardedCache.empty());
+    ASSERT_FALSE(shardedCache.get(1, value));
+}
+
+TEST_F(ShardedLRUCacheTests, TestCapacitySplitBetweenShards)
+{
+    pluto::ShardedLRUCache<std::size_t, std::size_t, SHARDED_CACHE_SHARDS> unevenCache{ 10 };
+    ASSERT_EQ(unevenCache.capacity(), 10);
+
+    // Each shard holds at most its share, so the cache never holds more than the capacity
+    for (std::size_t i{ 0 }; i < 1000; ++i)
+    {
+        shardedCache.insert(i, i);
+        unevenCache.insert(i, i);
+    }
+
+    ASSERT_EQ(shardedCache.size(), SHARDED_CACHE_CAPACITY);
+    ASSERT_EQ(unevenCache.size(), 10);
+
+    shardedCache.capacity(SHARDED_CACHE_CAPACITY / 2);
+    ASSERT_EQ(shardedCache.capacity(), SHARDED_CACHE_CAPACITY / 2);
+    ASSERT_EQ(shardedCache.size(), SHARDED_CACHE_CAPACITY / 2);
+}
+
+TEST_F(ShardedLRUCacheTests, TestCapacityBelowShards)
+{
+    // Raised to one entry per shard
+    pluto::ShardedLRUCache<std::size_t, std::size_t, 16> smallCache{ 4 };
+    ASSERT_EQ(smallCache.capacity(), 16);
+
+    for (std::size_t i{ 0 }; i < 1000; ++i)
+    {
+        ASSERT_TRUE(smallCache.insert(i, i));
+        ASSERT_TRUE(smallCache.contains(i));
+    }
+
+    ASSERT_EQ(smallCache.size(), 16);
+
+    smallCache.capacity(0);
+    ASSERT_EQ(smallCache.capacity(), 0);
+    ASSERT_TRUE(smallCache.empty());
+}
+
+TEST_F(ShardedLRUCacheTests, TestInsertAndGet)
+{
+    for (std::size_t i{ 1 }; i <= SHARDED_CACHE_CAPACITY / 2; ++i)
+    {
+        shardedCache.insert(i, i);
+    }
+
+    for (std::size_t i{ 1 }; i <= SHARDED_CACHE_CAPACITY / 2; ++i)
+    {
+        std::size_t value{ 0 };
+        ASSERT_TRUE(shardedCache.get(i, value));
+        ASSERT_EQ(value, i);
+    }
+
+    shardedCache.insert(1, 2);
+
+    std::size_t value{ 0 };
+    ASSERT_TRUE(shardedCache.get(1, value));
+    ASSERT_EQ(value, 2);
+}
+
+TEST_F(ShardedLRUCacheTests, TestGlobalLRUEvictsOldest)
+{
+    ASSERT_TRUE(globalCache.approximateGlobalLRU());
+
+    for (std::size_t i{ 1 }; i <= SHARDED_CACHE_CAPACITY; ++i)
+    {
+        globalCache.insert(i, i);
+    }
+
+    // Keeps the clock from giving the next accesses the same time as the inserts
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    std::size_t value{ 0 };
+    ASSERT_TRUE(globalCache.get(1, value));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // However the keys are spread, the whole capacity is used and the oldest entries go first
+    for (std::size_t i{ SHARDED_CACHE_CAPACITY + 1 }; i <= SHARDED_CACHE_CAPACITY + 10; ++i)
+    {
+        globalCache.insert(i, i);
+    }
+
+    ASSERT_EQ(globalCache.size(), SHARDED_CACHE_CAPACITY);
+    ASSERT_EQ(globalCache.capacity(), SHARDED_CACHE_CAPACITY);
+    ASSERT_TRUE(globalCache.contains(1));
+
+    for (std::size_t i{ 2 }; i <= 11; ++i)
+    {
+        ASSERT_FALSE(globalCache.contains(i));
+    }
+
+    for (std::size_t i{ 12 }; i <= SHARDED_CACHE_CAPACITY + 10; ++i)
+    {
+        ASSERT_TRUE(globalCache.contains(i));
+    }
+
+    globalCache.capacity(SHARDED_CACHE_CAPACITY / 2);
+    ASSERT_EQ(globalCache.size(), SHARDED_CACHE_CAPACITY / 2);
+    ASSERT_TRUE(globalCache.contains(SHARDED_CACHE_CAPACITY + 10));
+}
+
+TEST_F(ShardedLRUCacheTests, TestConcurrentAccess)
+{
+    const std::size_t numThreads{ 4 };
+    const std::size_t numKeys{ 1000 };
+    std::vector<std::thread> threads{};
+
+    for (std::size_t t{ 0 }; t < numThreads; ++t)
+    {
+        threads.emplace_back([this, t, numKeys]()
+        {
+            for (std::size_t i{ 0 }; i < numKeys; ++i)
+            {
+                const auto key{ (t * numKeys) + i };
+                std::size_t value{ 0 };
+
+                shardedCache.insert(key, key);
+                globalCache.insert(key, key);
+
+                if (shardedCache.get(key, value))
+                {
+                    ASSERT_EQ(value, key);
+                }
+
+                if (globalCache.get(key, value))
+                {
+                    ASSERT_EQ(value, key);
+                }
+
+                if ((i % 3) == 0)
+                {
+                    globalCache.remove(key);
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(shardedCache.size(), SHARDED_CACHE_CAPACITY);
+    ASSERT_LE(globalCache.size(), SHARDED_CACHE_CAPACITY);
+}
+
+TEST_F(ShardedLRUCacheTests, TestWeightedCapacity)
+{
+    pluto::ShardedLRUCache<std::size_t, std::string, SHARDED_CACHE_SHARDS, std::hash<std::size_t>,
+        std::equal_to<std::size_t>, pluto::LRUPolicy, LengthWeigher> weightedCache{ SHARDED_CACHE_CAPACITY * 10 };
+
+    pluto::ShardedLRUCache<std::size_t, std::string, SHARDED_CACHE_SHARDS, std::hash<std::size_t>,
+        std::equal_to<std::size_t>, pluto::LRUPolicy, LengthWeigher> globalWeightedCache{ SHARDED_CACHE_CAPACITY * 10, false, true };
+
+    for (std::size_t i{ 0 }; i < 1000; ++i)
+    {
+        const std::string value(1 + (i % 20), 'a');
+        ASSERT_TRUE(weightedCache.insert(i, value));
+        ASSERT_TRUE(globalWeightedCache.insert(i, value));
+    }
+
+    // Each shard holds at most its share of the weight
+    const auto weights{ weightedCache.shardWeights() };
+    std::size_t totalWeight{ 0 };
+    for (const auto weight : weights)
+    {
+        ASSERT_LE(weight, (SHARDED_CACHE_CAPACITY * 10) / SHARDED_CACHE_SHARDS);
+        totalWeight += weight;
+    }
+
+    ASSERT_EQ(weightedCache.weight(), totalWeight);
+    ASSERT_LE(globalWeightedCache.weight(), SHARDED_CACHE_CAPACITY * 10);
+    ASSERT_GT(globalWeightedCache.weight(), (SHARDED_CACHE_CAPACITY * 10) - 20);
+
+    // Heavier than a shard's share, but only the global mode has room for it anywhere
+    const std::string heavy((SHARDED_CACHE_CAPACITY * 10) / 2, 'b');
+    ASSERT_FALSE(weightedCache.insert(2000, heavy));
+    ASSERT_TRUE(globalWeightedCache.insert(2000, heavy));
+    ASSERT_TRUE(globalWeightedCache.contains(2000));
+    ASSERT_LE(globalWeightedCache.weight(), SHARDED_CACHE_CAPACITY * 10);
+
+    ASSERT_FALSE(globalWeightedCache.insert(2001, std::string((SHARDED_CACHE_CAPACITY * 10) + 1, 'c')));
+    ASSERT_TRUE(globalWeightedCache.contains(2000));
+}
@@ -0,0 +1,19 @@
+/*
+* Copyright (c) 2024 Stephen O Driscoll
+*
+* Distributed under the MIT License (See accompanying file LICENSE)
+* Official repository: https://github.com/Stephen-ODriscoll/PlutoUtils
+*/
+
+// Weighers shared by the cache tests
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// Weighs strings by their length
+struct LengthWeigher
+{
+    std::size_t operator()(const std::size_t, const std::string& value) const { return value.size(); }
+};
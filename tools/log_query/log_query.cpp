@@ -0,0 +1,40 @@
+/*
+* Copyright (c) 2024 Stephen O Driscoll
+*
+* Distributed under the MIT License (See accompanying file LICENSE)
+* Official repository: https://github.com/Stephen-ODriscoll/PlutoUtils
+*/
+
+// Prints the logs in a time range from Logger files, optionally filtered by level or thread.
+// When a file has a sidecar index (see Logger::fileIndexInterval) only the part of the file
+// around the range is scanned. Timestamps are compared as text, so they must use the default format.
+//
+// Usage: pluto_log_query [--from time] [--to time] [--level level] [--thread id] [--separator text] files...
+// Times look like "2026-10-17 13:00:05" and may be cut short, "--to 2026-10-17 13" includes all of 13:xx.
+
+#include "log_query.hpp"
+
+int main(int argc, char* argv[])
+{
+    Query query{};
+    std::vector<std::string> fileNames{};
+
+    if (!parseArguments(argc, argv, query, fileNames))
+    {
+        std::cerr << "Usage: " << argv[0]
+            << " [--from time] [--to time] [--level level] [--thread id] [--separator text] files..." << std::endl;
+
+        return 1;
+    }
+
+    std::size_t numMatches{ 0 };
+    for (const auto& fileName : fileNames)
+    {
+        numMatches += queryFile(fileName, query);
+    }
+
+    std::fflush(stdout);
+    std::cerr << numMatches << " logs matched" << std::endl;
+
+    return 0;
+}
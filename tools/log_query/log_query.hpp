@@ -0,0 +1,383 @@
+/*
+* Copyright (c) 2024 Stephen O Driscoll
+*
+* Distributed under the MIT License (See accompanying file LICENSE)
+* Official repository: https://github.com/Stephen-ODriscoll/PlutoUtils
+*/
+
+// Reading and filtering for pluto_log_query, see log_query.cpp
+
+#pragma once
+
+#include "pluto/logger.hpp"
+
+#include <cstdio>
+#include <iostream>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+struct Query
+{
+    std::string from        {};
+    std::string to          {};
+    std::string level       {};
+    std::string thread      {};
+    std::string separator   { PLUTO_LOGGER_DEFAULT_SEPARATOR };
+};
+
+// Read only view of a whole file, mapped where possible
+class MappedFile
+{
+    const char*     m_data;
+    std::size_t     m_size;
+#ifdef _WIN32
+    std::string     m_contents;
+#endif
+
+public:
+    explicit MappedFile(const std::string& fileName) :
+        m_data{ nullptr },
+        m_size{ 0 }
+    {
+#ifdef _WIN32
+        std::ifstream fileStream{ fileName, std::ios_base::binary };
+        m_contents.assign(std::istreambuf_iterator<char>{ fileStream }, std::istreambuf_iterator<char>{});
+        m_data = m_contents.data();
+        m_size = m_contents.size();
+#else
+        const auto fd{ ::open(fileName.c_str(), (O_RDONLY | O_CLOEXEC)) };
+        struct stat fileStat{};
+
+        if (fd != -1 && ::fstat(fd, &fileStat) == 0 && fileStat.st_size != 0)
+        {
+            const auto size{ static_cast<std::size_t>(fileStat.st_size) };
+            const auto map{ ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) };
+
+            if (map != MAP_FAILED)
+            {
+                ::madvise(map, size, MADV_SEQUENTIAL);
+                m_data = static_cast<const char*>(map);
+                m_size = size;
+            }
+        }
+
+        if (fd != -1)
+        {
+            ::close(fd);
+        }
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifndef _WIN32
+        if (m_data != nullptr)
+        {
+            ::munmap(const_cast<char*>(m_data), m_size);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+
+    void operator=(const MappedFile&) = delete;
+
+    const char* data()  const { return m_data; }
+    std::size_t size()  const { return m_size; }
+};
+
+inline std::string trim(const std::string& text)
+{
+    const auto begin{ text.find_first_not_of(' ') };
+    if (begin == std::string::npos)
+    {
+        return {};
+    }
+
+    return text.substr(begin, (text.find_last_not_of(' ') - begin + 1));
+}
+
+// Column of a line in the mapped file, so scanning doesn't copy
+struct Column
+{
+    const char* begin;
+    const char* end;
+};
+
+// Compares the start of the column with text, as if the column was cut to the length of text
+inline int compareStart(const Column& column, const std::string& text)
+{
+    const auto length{ std::min(static_cast<std::size_t>(column.end - column.begin), text.size()) };
+    const auto result{ std::memcmp(column.begin, text.data(), length) };
+
+    return ((result != 0) ? result : ((length < text.size()) ? -1 : 0));
+}
+
+inline bool equalsTrimmed(Column column, const std::string& text)
+{
+    for (; column.begin != column.end && *column.begin == ' '; ++column.begin);
+    for (; column.end != column.begin && *(column.end - 1) == ' '; --column.end);
+
+    return (static_cast<std::size_t>(column.end - column.begin) == text.size() &&
+        std::memcmp(column.begin, text.data(), text.size()) == 0);
+}
+
+// Splits off the first numColumns columns, only as many as the query needs
+inline bool splitColumns(
+    const char* const       begin,
+    const char* const       end,
+    const std::string&      separator,
+    const std::size_t       numColumns,
+    std::vector<Column>&    columns)
+{
+    columns.clear();
+
+    auto it{ begin };
+    for (auto search{ begin }; columns.size() < numColumns; )
+    {
+        const auto next{ static_cast<const char*>(std::memchr(search, separator[0], static_cast<std::size_t>(end - search))) };
+        if (next == nullptr || static_cast<std::size_t>(end - next) < separator.size())
+        {
+            return false;
+        }
+
+        if (std::memcmp(next, separator.data(), separator.size()) == 0)
+        {
+            columns.push_back({ it, next });
+            it = next + separator.size();
+            search = it;
+        }
+        else
+        {
+            search = next + 1;
+        }
+    }
+
+    return true;
+}
+
+// Time of a query bound and how long the bound covers, "2026-10-17 13" covers an hour.
+// Returns false if it isn't in the default timestamp format.
+inline bool parseTime(const std::string& text, pluto::Logger::Clock::time_point& time, std::chrono::seconds& span)
+{
+    std::tm localTime{};
+    localTime.tm_mday = 1;
+
+    const auto numParsed{ std::sscanf(text.c_str(), "%d-%d-%d %d:%d:%d", &localTime.tm_year, &localTime.tm_mon,
+        &localTime.tm_mday, &localTime.tm_hour, &localTime.tm_min, &localTime.tm_sec) };
+
+    if (numParsed < 1)
+    {
+        return false;
+    }
+
+    switch (numParsed)
+    {
+        case 1:     span = std::chrono::hours(366 * 24);    break;
+        case 2:     span = std::chrono::hours(31 * 24);     break;
+        case 3:     span = std::chrono::hours(24);          break;
+        case 4:     span = std::chrono::hours(1);           break;
+        case 5:     span = std::chrono::minutes(1);         break;
+        default:    span = std::chrono::seconds(1);         break;
+    }
+
+    localTime.tm_year -= 1900;
+    localTime.tm_mon -= 1;
+    localTime.tm_isdst = -1;
+
+    time = pluto::Logger::Clock::from_time_t(std::mktime(&localTime));
+    return true;
+}
+
+// Part of the file that can hold logs in the query's range, found with a binary search of the index.
+// Index timestamps never go back, but the logs between entries are timestamped before they're queued and can be
+// a little out of order, so the search allows a second either side.
+inline void findRange(const std::string& fileName, const Query& query, std::size_t& begin, std::size_t& end)
+{
+    typedef pluto::Logger::IndexEntry IndexEntry;
+
+    std::vector<IndexEntry> entries{};
+
+    {
+        std::ifstream indexStream{ pluto::Logger::getIndexFilePath(fileName), std::ios_base::binary };
+        IndexEntry entry{};
+
+        while (indexStream.read(reinterpret_cast<char*>(&entry), sizeof(entry)))
+        {
+            entries.push_back(entry);
+        }
+    }
+
+    const auto toNanoseconds{ [](const pluto::Logger::Clock::time_point time)
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        } };
+
+    const auto margin{ std::chrono::seconds(1) };
+    pluto::Logger::Clock::time_point time{};
+    std::chrono::seconds span{};
+
+    if (!query.from.empty() && parseTime(query.from, time, span))
+    {
+        const auto from{ toNanoseconds(time - margin) };
+        const auto it{ std::lower_bound(entries.begin(), entries.end(), from,
+            [](const IndexEntry& entry, const std::int64_t value) { return (entry.timestamp < value); }) };
+
+        // Logs before the first one at or after from can still be in range up to the entry before it
+        if (it != entries.begin())
+        {
+            begin = static_cast<std::size_t>(std::prev(it)->offset);
+        }
+    }
+
+    if (!query.to.empty() && parseTime(query.to, time, span))
+    {
+        const auto to{ toNanoseconds(time + span + margin) };
+        const auto it{ std::upper_bound(entries.begin(), entries.end(), to,
+            [](const std::int64_t value, const IndexEntry& entry) { return (value < entry.timestamp); }) };
+
+        if (it != entries.end())
+        {
+            end = std::min(end, static_cast<std::size_t>(it->offset));
+        }
+    }
+
+    // An index left from a longer file can point past the end
+    begin = std::min(begin, end);
+}
+
+inline std::size_t queryFile(const std::string& fileName, const Query& query)
+{
+    const MappedFile file{ fileName };
+    if (file.data() == nullptr)
+    {
+        return 0;
+    }
+
+    const auto data{ file.data() };
+
+    // Use the column layout from the header if there is one
+    std::vector<std::string> columnNames{
+        PLUTO_LOGGER_DEFAULT_TIMESTAMP_HEADER,
+        PLUTO_LOGGER_DEFAULT_PROCESS_ID_HEADER,
+        PLUTO_LOGGER_DEFAULT_THREAD_ID_HEADER,
+        "Level",
+        PLUTO_LOGGER_DEFAULT_FILE_NAME_HEADER,
+        PLUTO_LOGGER_DEFAULT_LINE_HEADER,
+        PLUTO_LOGGER_DEFAULT_FUNCTION_HEADER };
+
+    {
+        const auto lineEnd{ std::find(data, data + file.size(), '\n') };
+        std::vector<std::string> header{};
+
+        for (auto it{ data }; ; )
+        {
+            const auto next{ std::search(it, lineEnd, query.separator.begin(), query.separator.end()) };
+            header.push_back(trim({ it, next }));
+
+            if (next == lineEnd)
+            {
+                break;
+            }
+
+            it = next + query.separator.size();
+        }
+
+        if (1 < header.size() && header[0] == PLUTO_LOGGER_DEFAULT_TIMESTAMP_HEADER)
+        {
+            header.pop_back();  // Message
+            columnNames = header;
+        }
+    }
+
+    const auto findColumn{ [&](const std::string& name)
+        {
+            return static_cast<std::size_t>(
+                std::distance(columnNames.begin(), std::find(columnNames.begin(), columnNames.end(), name)));
+        } };
+
+    const auto timestampColumn  { findColumn(PLUTO_LOGGER_DEFAULT_TIMESTAMP_HEADER) };
+    const auto threadColumn     { findColumn(PLUTO_LOGGER_DEFAULT_THREAD_ID_HEADER) };
+    const auto levelColumn      { findColumn("Level") };
+
+    // Missing columns are past the end, so the filters using them never match
+    auto numColumns{ timestampColumn + 1 };
+    if (!query.level.empty())
+    {
+        numColumns = std::max(numColumns, levelColumn + 1);
+    }
+
+    if (!query.thread.empty())
+    {
+        numColumns = std::max(numColumns, threadColumn + 1);
+    }
+
+    numColumns = std::min(numColumns, columnNames.size());
+
+    std::size_t begin{ 0 };
+    std::size_t end{ file.size() };
+    findRange(fileName, query, begin, end);
+
+    std::vector<Column> columns{};
+    std::size_t numMatches{ 0 };
+    auto isMatch{ false };
+
+    for (auto it{ data + begin }; it < (data + end); )
+    {
+        auto lineEnd{ static_cast<const char*>(std::memchr(it, '\n', static_cast<std::size_t>(data + file.size() - it))) };
+        if (lineEnd == nullptr)
+        {
+            lineEnd = data + file.size();
+        }
+
+        const auto next{ (lineEnd == (data + file.size())) ? lineEnd : (lineEnd + 1) };
+
+        // Lines that don't start with a timestamp are headers or continue a multi-line message
+        if (splitColumns(it, lineEnd, query.separator, numColumns, columns) && timestampColumn < numColumns &&
+            columns[timestampColumn].begin != columns[timestampColumn].end &&
+            '0' <= *columns[timestampColumn].begin && *columns[timestampColumn].begin <= '9')
+        {
+            const auto& timestamp{ columns[timestampColumn] };
+
+            isMatch =
+                (query.from.empty() || 0 <= compareStart(timestamp, query.from)) &&
+                (query.to.empty() || compareStart(timestamp, query.to) <= 0) &&
+                (query.level.empty() || (levelColumn < numColumns && equalsTrimmed(columns[levelColumn], query.level))) &&
+                (query.thread.empty() || (threadColumn < numColumns && equalsTrimmed(columns[threadColumn], query.thread)));
+
+            if (isMatch)
+            {
+                ++numMatches;
+            }
+        }
+
+        if (isMatch)
+        {
+            std::fwrite(it, 1, static_cast<std::size_t>(next - it), stdout);
+        }
+
+        it = next;
+    }
+
+    return numMatches;
+}
+
+// Returns false if there are no files or the separator is empty, which would never split a line
+inline bool parseArguments(const int argc, const char* const argv[], Query& query, std::vector<std::string>& fileNames)
+{
+    for (int i{ 1 }; i < argc; ++i)
+    {
+        const std::string arg{ argv[i] };
+
+        if ((i + 1) < argc && arg == "--from")              { query.from = argv[++i]; }
+        else if ((i + 1) < argc && arg == "--to")           { query.to = argv[++i]; }
+        else if ((i + 1) < argc && arg == "--level")        { query.level = argv[++i]; }
+        else if ((i + 1) < argc && arg == "--thread")       { query.thread = argv[++i]; }
+        else if ((i + 1) < argc && arg == "--separator")    { query.separator = argv[++i]; }
+        else                                                { fileNames.push_back(arg); }
+    }
+
+    return (!fileNames.empty() && !query.separator.empty());
+}